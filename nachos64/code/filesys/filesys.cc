@@ -50,6 +50,8 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "synch.h"
+#include "system.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -80,6 +82,12 @@
 FileSystem::FileSystem(bool format)
 { 
     DEBUG('f', "Initializing the file system.\n");
+    directoryLock = new RWLock("directory");
+    freeMapLock = new RWLock("free map");
+    headerLocks = new RWLock*[NumSectors];
+    for (int i = 0; i < NumSectors; i++)
+	headerLocks[i] = NULL;
+
     if (format) {
         BitMap *freeMap = new BitMap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
@@ -142,6 +150,26 @@ FileSystem::FileSystem(bool format)
     }
 }
 
+//----------------------------------------------------------------------
+// FileSystem::HeaderLock
+// 	Return the lock protecting the file whose header is at "sector",
+//	making it the first time the file is used.  The lock outlives the
+//	file, and is reused by any later file whose header gets the sector.
+//
+//	"sector" -- the location on disk of the file header
+//----------------------------------------------------------------------
+
+RWLock *
+FileSystem::HeaderLock(int sector)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);	// make it only once
+
+    if (headerLocks[sector] == NULL)
+	headerLocks[sector] = new RWLock("file header");
+    interrupt->SetLevel(oldLevel);
+    return headerLocks[sector];
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Create
 // 	Create a file in the Nachos file system (similar to UNIX create).
@@ -164,8 +192,8 @@ FileSystem::FileSystem(bool format)
 //	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
 //
-// 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
+// 	The directory and the bitmap are held for writing throughout, so
+//	nobody can see the file until it is complete.
 //
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
@@ -182,12 +210,14 @@ FileSystem::Create(const char *name, int initialSize)
 
     DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
 
+    directoryLock->AcquireWrite();
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
 
     if (directory->Find(name) != -1)
       success = false;			// file is already in directory
     else {	
+        freeMapLock->AcquireWrite();
         freeMap = new BitMap(NumSectors);
         freeMap->FetchFrom(freeMapFile);
         sector = freeMap->Find();	// find a sector to hold the file header
@@ -209,8 +239,10 @@ FileSystem::Create(const char *name, int initialSize)
             delete hdr;
 	}
         delete freeMap;
+        freeMapLock->ReleaseWrite();
     }
     delete directory;
+    directoryLock->ReleaseWrite();
     return success;
 }
 
@@ -221,6 +253,10 @@ FileSystem::Create(const char *name, int initialSize)
 //	  Find the location of the file's header, using the directory 
 //	  Bring the header into memory
 //
+//	The directory is only held for reading, so several threads can
+//	open files at once.  It is held until the header is in memory, so
+//	the file can't be removed halfway through.
+//
 //	"name" -- the text name of the file to be opened
 //----------------------------------------------------------------------
 
@@ -232,10 +268,13 @@ FileSystem::Open(const char *name)
     int sector;
 
     DEBUG('f', "Opening file %s\n", name);
+    directoryLock->AcquireRead();
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name); 
     if (sector >= 0) 		
-	openFile = new OpenFile(sector);	// name was found in directory 
+	openFile = new OpenFile(sector, HeaderLock(sector));
+						// name was found in directory 
+    directoryLock->ReleaseRead();
     delete directory;
     return openFile;				// return NULL if not found
 }
@@ -251,6 +290,10 @@ FileSystem::Open(const char *name)
 //	Return true if the file was deleted, false if the file wasn't
 //	in the file system.
 //
+//	The file itself is held for writing while its blocks are freed,
+//	so reads and writes already under way through an open file finish
+//	first.
+//
 //	"name" -- the text name of the file to be removed
 //----------------------------------------------------------------------
 
@@ -262,13 +305,17 @@ FileSystem::Remove(const char *name)
     FileHeader *fileHdr;
     int sector;
     
+    directoryLock->AcquireWrite();
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
     if (sector == -1) {
+       directoryLock->ReleaseWrite();
        delete directory;
        return false;			 // file not found 
     }
+    freeMapLock->AcquireWrite();
+    HeaderLock(sector)->AcquireWrite();
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
@@ -281,6 +328,9 @@ FileSystem::Remove(const char *name)
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
     directory->WriteBack(directoryFile);        // flush to disk
+    HeaderLock(sector)->ReleaseWrite();
+    freeMapLock->ReleaseWrite();
+    directoryLock->ReleaseWrite();
     delete fileHdr;
     delete directory;
     delete freeMap;
@@ -297,7 +347,9 @@ FileSystem::List()
 {
     Directory *directory = new Directory(NumDirEntries);
 
+    directoryLock->AcquireRead();
     directory->FetchFrom(directoryFile);
+    directoryLock->ReleaseRead();
     directory->List();
     delete directory;
 }
@@ -328,10 +380,14 @@ FileSystem::Print()
     dirHdr->FetchFrom(DirectorySector);
     dirHdr->Print();
 
+    freeMapLock->AcquireRead();
     freeMap->FetchFrom(freeMapFile);
+    freeMapLock->ReleaseRead();
     freeMap->Print();
 
+    directoryLock->AcquireRead();
     directory->FetchFrom(directoryFile);
+    directoryLock->ReleaseRead();
     directory->Print();
 
     delete bitHdr;
@@ -28,6 +28,13 @@
 //	stored as files in the Nachos file system -- this causes an interesting
 //	bootstrap problem when the simulated disk is initialized. 
 //
+//	Several threads may use the "real" file system at once.  The
+//	directory, the bitmap and each file header have a reader-writer
+//	lock: looking a name up only needs the directory for reading, so
+//	opens proceed together, while Create and Remove update the
+//	directory and the bitmap alone.  Locks are always acquired in that
+//	order -- directory, bitmap, file header -- so there is no deadlock.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -65,6 +72,8 @@ class FileSystem {
 };
 
 #else // FILESYS
+class RWLock;
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -90,6 +99,12 @@ class FileSystem {
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+   RWLock* directoryLock;		// Protects the directory
+   RWLock* freeMapLock;			// Protects the bitmap
+   RWLock** headerLocks;		// Protects each file, by the sector
+					// of its header; made when first used
+
+   RWLock* HeaderLock(int sector);	// The lock for the file at "sector"
 };
 
 #endif // FILESYS
@@ -14,6 +14,7 @@
 #include "copyright.h"
 #include "filehdr.h"
 #include "openfile.h"
+#include "synch.h"
 #include "system.h"
 
 //----------------------------------------------------------------------
@@ -22,12 +23,16 @@
 //	into memory while the file is open.
 //
 //	"sector" -- the location on disk of the file header for this file
+//	"headerLock" -- the file system's lock for this file; NULL for the
+//		directory and bitmap files, which are protected by their
+//		own locks
 //----------------------------------------------------------------------
 
-OpenFile::OpenFile(int sector)
+OpenFile::OpenFile(int sector, RWLock *headerLock)
 { 
     hdr = new FileHeader;
     hdr->FetchFrom(sector);
+    hdrLock = headerLock;
     seekPosition = 0;
 }
 
@@ -103,6 +108,10 @@ OpenFile::Write(const char *into, int numBytes)
 //	   in the data that will be modified, and write back all the full
 //	   or partial sectors that are part of the request.
 //
+//	Reads hold the file's lock for reading, so reads of the same file
+//	overlap; writes hold it for writing, so that the sectors they
+//	read and write back are not changed in between.
+//
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
 //	"numBytes" -- the number of bytes to transfer
@@ -130,9 +139,13 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
 
     // read in all the full and partial sectors that we need
     buf = new char[numSectors * SectorSize];
+    if (hdrLock != NULL)
+	hdrLock->AcquireRead();
     for (i = firstSector; i <= lastSector; i++)	
         synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
 					&buf[(i - firstSector) * SectorSize]);
+    if (hdrLock != NULL)
+	hdrLock->ReleaseRead();
 
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
@@ -164,12 +177,16 @@ OpenFile::WriteAt(const char *from, int numBytes, int position)
     firstAligned = (position == (firstSector * SectorSize));
     lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
 
+    if (hdrLock != NULL)
+	hdrLock->AcquireWrite();
+
 // read in first and last sector, if they are to be partially modified
     if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);	
+        synchDisk->ReadSector(hdr->ByteToSector(firstSector * SectorSize),
+					buf);
     if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
-				SectorSize, lastSector * SectorSize);	
+        synchDisk->ReadSector(hdr->ByteToSector(lastSector * SectorSize),
+				&buf[(lastSector - firstSector) * SectorSize]);
 
 // copy in the bytes we want to change 
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
@@ -178,6 +195,8 @@ OpenFile::WriteAt(const char *from, int numBytes, int position)
     for (i = firstSector; i <= lastSector; i++)	
         synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
 					&buf[(i - firstSector) * SectorSize]);
+    if (hdrLock != NULL)
+	hdrLock->ReleaseWrite();
     delete [] buf;
     return numBytes;
 }
@@ -60,11 +60,14 @@ class OpenFile {
 
 #else // FILESYS
 class FileHeader;
+class RWLock;
 
 class OpenFile {
   public:
-    OpenFile(int sector);		// Open a file whose header is located
-					// at "sector" on the disk
+    OpenFile(int sector, RWLock *headerLock = NULL);
+					// Open a file whose header is located
+					// at "sector" on the disk; reads and
+					// writes hold "headerLock", if any
     ~OpenFile();			// Close the file
 
     void Seek(int position); 		// Set the position from which to 
@@ -89,6 +92,7 @@ class OpenFile {
     
   private:
     FileHeader *hdr;			// Header for this file 
+    RWLock *hdrLock;			// Shared by every open of the file
     int seekPosition;			// Current position within the file
 };
 
@@ -8,7 +8,8 @@
 //	Use a semaphore to synchronize the interrupt handlers with the
 //	pending requests.  And, because the physical disk can only
 //	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	exclusion.  The interrupt handler only posts a bottom half; the
+//	waiting thread is woken up once interrupts are enabled again.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,6 +17,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -31,6 +33,20 @@ DiskRequestDone (void* arg)
     disk->RequestDone();
 }
 
+//----------------------------------------------------------------------
+// WakeRequester
+// 	Bottom half of the disk interrupt: wake up the thread waiting
+//	for the request, on semaphore "arg".
+//----------------------------------------------------------------------
+
+static void
+WakeRequester (void* arg)
+{
+    Semaphore* semaphore = (Semaphore *)arg;
+
+    semaphore->V();
+}
+
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
 // 	Initialize the synchronous interface to the physical disk, in turn
@@ -43,6 +59,7 @@ DiskRequestDone (void* arg)
 SynchDisk::SynchDisk(const char* name)
 {
     semaphore = new Semaphore("synch disk", 0);
+    requestDone = new SoftInterrupt(WakeRequester, semaphore);
     lock = new Lock("synch disk lock");
     disk = new Disk(name, DiskRequestDone, this);
 }
@@ -57,6 +74,7 @@ SynchDisk::~SynchDisk()
 {
     delete disk;
     delete lock;
+    delete requestDone;
     delete semaphore;
 }
 
@@ -98,12 +116,12 @@ SynchDisk::WriteSector(int sectorNumber, const char* data)
 
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Arrange to wake up any thread waiting
+//	for the disk request to finish, once the handler returns.
 //----------------------------------------------------------------------
 
 void
 SynchDisk::RequestDone()
 { 
-    semaphore->V();
+    interrupt->Post(requestDone);
 }
@@ -14,6 +14,8 @@
 #include "disk.h"
 #include "synch.h"
 
+class SoftInterrupt;
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -46,6 +48,8 @@ class SynchDisk {
     Disk *disk;		  		// Raw disk device
     Semaphore *semaphore; 		// To synchronize requesting thread 
 					// with the interrupt handler
+    SoftInterrupt *requestDone;		// V's "semaphore" once the handler
+					// returns
     Lock *lock;		  		// Only one read/write request
 					// can be sent to the disk at a time
 };
@@ -56,8 +56,9 @@ Console::Console(const char *readFile, const char *writeFile,
     putBusy = false;
     incoming = EOF;
 
-    // start polling for incoming packets
-    interrupt->Schedule(ConsoleReadPoll, this, ConsoleTime, ConsoleReadInt);
+    // interrupt when a character is typed, on a poll boundary
+    readWatch = hostIO->Watch(readFileNo, ConsoleReadPoll, this,
+			      ConsoleReadInt, ConsoleTime);
 }
 
 //----------------------------------------------------------------------
@@ -67,6 +68,7 @@ Console::Console(const char *readFile, const char *writeFile,
 
 Console::~Console()
 {
+    hostIO->Unwatch(readWatch);
     if (readFileNo != 0)
 	Close(readFileNo);
     if (writeFileNo != 1)
@@ -75,13 +77,13 @@ Console::~Console()
 
 //----------------------------------------------------------------------
 // Console::CheckCharAvail()
-// 	Periodically called to check if a character is available for
-//	input from the simulated keyboard (eg, has it been typed?).
+// 	Called when a character is available for input from the
+//	simulated keyboard (eg, it has been typed).
 //
-//	Only read it in if there is buffer space for it (if the previous
-//	character has been grabbed out of the buffer by the Nachos kernel).
-//	Invoke the "read" interrupt handler, once the character has been 
-//	put into the buffer. 
+//	The host I/O reactor only reports it once the previous character
+//	has been grabbed out of the buffer by the Nachos kernel.  Read it
+//	in, and invoke the "read" interrupt handler, once the character
+//	has been put into the buffer.
 //----------------------------------------------------------------------
 
 void
@@ -89,15 +91,7 @@ Console::CheckCharAvail()
 {
     char c;
 
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(ConsoleReadPoll, this, ConsoleTime, 
-			ConsoleReadInt);
-
-    // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
+    // read character and tell user about it
     Read(readFileNo, &c, sizeof(char));
     incoming = c ;
     stats->numConsoleCharsRead++;
@@ -122,7 +116,8 @@ Console::WriteDone()
 //----------------------------------------------------------------------
 // Console::GetChar()
 // 	Read a character from the input buffer, if there is any there.
-//	Either return the character, or EOF if none buffered.
+//	Either return the character, or EOF if none buffered.  The buffer
+//	is free again, so go back to watching the keyboard.
 //----------------------------------------------------------------------
 
 char
@@ -131,6 +126,7 @@ Console::GetChar()
    char ch = incoming;
 
    incoming = EOF;
+   hostIO->Rearm(readWatch);
    return ch;
 }
 
@@ -71,6 +71,8 @@ class Console {
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
+    int readWatch;			// Host I/O watch on the keyboard;
+					// disarmed while "incoming" is full
 };
 
 #endif // CONSOLE_H
@@ -234,19 +234,21 @@ Disk::ComputeLatency(int newSector, bool writing)
 {
     int rotation;
     int seek = TimeToSeek(newSector, &rotation);
-    int timeAfter = stats->totalTicks + seek + rotation;
+    long long timeAfter = stats->totalTicks + seek + rotation;
 
 #ifndef NOTRACKBUF	// turn this on if you don't want the track buffer stuff
     // check if track buffer applies
     if ((writing == false) && (seek == 0) 
 		&& (((timeAfter - bufferInit) / RotationTime) 
-	     		> ModuloDiff(newSector, bufferInit / RotationTime))) {
+	     		> ModuloDiff(newSector,
+			     (int) ((bufferInit / RotationTime) % SectorsPerTrack)))) {
         DEBUG('d', "Request latency = %d\n", RotationTime);
 	return RotationTime; // time to transfer sector from the track buffer
     }
 #endif
 
-    rotation += ModuloDiff(newSector, timeAfter / RotationTime) * RotationTime;
+    rotation += ModuloDiff(newSector,
+		(int) ((timeAfter / RotationTime) % SectorsPerTrack)) * RotationTime;
 
     DEBUG('d', "Request latency = %d\n", seek + rotation + RotationTime);
     return(seek + rotation + RotationTime);
@@ -267,5 +269,5 @@ Disk::UpdateLast(int newSector)
     if (seek != 0)
 	bufferInit = stats->totalTicks + seek + rotate;
     lastSector = newSector;
-    DEBUG('d', "Updating last sector = %d, %d\n", lastSector, bufferInit);
+    DEBUG('d', "Updating last sector = %d, %lld\n", lastSector, bufferInit);
 }
@@ -0,0 +1,336 @@
+// hostio.cc
+//	Routines of the host I/O reactor: a host thread that waits for
+//	the UNIX descriptors behind the simulated devices to have input,
+//	and the simulation side that turns that input into interrupts.
+//
+//	The host thread never calls into the simulation; it only marks
+//	watches as ready, under the mutex.  All interrupts are scheduled
+//	by the simulation itself, from OneTick or Idle.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+
+#include "copyright.h"
+
+extern "C" {
+#include <poll.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+}
+
+#include "hostio.h"
+#include "system.h"
+
+// How long the idle machine blocks at a time, in host nanoseconds,
+// before looking for an accounting snapshot asked for meanwhile
+static const long IdleWaitSlice = 100 * 1000 * 1000;
+
+//----------------------------------------------------------------------
+// HostIOLoop
+// 	Body of the host thread.  Need this to be a C routine, because
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void *
+HostIOLoop(void *arg)
+{
+    HostIO *reactor = (HostIO *) arg;
+
+    reactor->Loop();
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// HostIO::HostIO
+// 	Initialize a reactor with nothing to watch.  The host thread is
+//	only started by the first Watch, so runs without the console or
+//	the network never have one.
+//----------------------------------------------------------------------
+
+HostIO::HostIO()
+{
+    for (int i = 0; i < MaxHostWatches; i++)
+	watches[i].inUse = watches[i].armed = watches[i].ready = false;
+    numArrivals = 0;
+    started = stopping = false;
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&arrived, NULL);
+    wakeFds[0] = wakeFds[1] = -1;
+
+    numDelivered = numIdleWaits = 0;
+}
+
+//----------------------------------------------------------------------
+// HostIO::~HostIO
+// 	Stop the host thread, if it was started, and wait for it.
+//----------------------------------------------------------------------
+
+HostIO::~HostIO()
+{
+    if (started) {
+	pthread_mutex_lock(&mutex);
+	stopping = true;
+	pthread_mutex_unlock(&mutex);
+	Wake();
+	pthread_join(thread, NULL);
+	close(wakeFds[0]);
+	close(wakeFds[1]);
+    }
+    pthread_cond_destroy(&arrived);
+    pthread_mutex_destroy(&mutex);
+}
+
+//----------------------------------------------------------------------
+// HostIO::Start
+// 	Create the wakeup pipe and the host thread.  The thread blocks
+//	every signal, so that SIGINT, SIGUSR1 and the -p time slices are
+//	still delivered to the simulation.
+//----------------------------------------------------------------------
+
+void
+HostIO::Start()
+{
+    sigset_t all, old;
+
+    ASSERT(pipe(wakeFds) == 0);
+    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    ASSERT(pthread_create(&thread, NULL, HostIOLoop, this) == 0);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    started = true;
+}
+
+//----------------------------------------------------------------------
+// HostIO::Wake
+// 	Make the host thread leave poll() and look at the watches again.
+//	If the pipe is full, it is already due to wake up.
+//----------------------------------------------------------------------
+
+void
+HostIO::Wake()
+{
+    char c = 0;
+
+    if (write(wakeFds[1], &c, 1) < 0)
+	return;
+}
+
+//----------------------------------------------------------------------
+// HostIO::Watch
+// 	Start watching "fd".  When it has input, interrupt "handler" is
+//	scheduled with "arg", at the next multiple of "interval" ticks.
+//	Return the id of the watch, for Rearm and Unwatch.
+//
+//	"type" is the device, for debugging.
+//----------------------------------------------------------------------
+
+int
+HostIO::Watch(int fd, VoidFunctionPtr handler, void* arg, IntType type,
+	      int interval)
+{
+    int watch;
+
+    if (!started)
+	Start();
+
+    pthread_mutex_lock(&mutex);
+    for (watch = 0; watch < MaxHostWatches; watch++)
+	if (!watches[watch].inUse)
+	    break;
+    ASSERT(watch < MaxHostWatches);
+
+    HostWatch *w = &watches[watch];
+    w->fd = fd;
+    w->handler = handler;
+    w->arg = arg;
+    w->type = type;
+    w->interval = interval;
+    w->inUse = true;
+    w->armed = true;
+    w->ready = false;
+    pthread_mutex_unlock(&mutex);
+
+    Wake();
+    return watch;
+}
+
+//----------------------------------------------------------------------
+// HostIO::Rearm
+// 	Watch again for input on "watch", after its interrupt.  Does
+//	nothing if the watch is still waiting for input.
+//----------------------------------------------------------------------
+
+void
+HostIO::Rearm(int watch)
+{
+    HostWatch *w = &watches[watch];
+    bool changed = false;
+
+    pthread_mutex_lock(&mutex);
+    if (w->inUse && !w->armed && !w->ready) {
+	w->armed = true;
+	changed = true;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    if (changed)
+	Wake();
+}
+
+//----------------------------------------------------------------------
+// HostIO::Unwatch
+// 	Stop watching "watch", before its descriptor is closed.  Input
+//	found but not yet delivered is dropped.
+//----------------------------------------------------------------------
+
+void
+HostIO::Unwatch(int watch)
+{
+    HostWatch *w = &watches[watch];
+
+    pthread_mutex_lock(&mutex);
+    if (w->ready)
+	__atomic_sub_fetch(&numArrivals, 1, __ATOMIC_RELEASE);
+    w->inUse = w->armed = w->ready = false;
+    pthread_mutex_unlock(&mutex);
+
+    Wake();
+}
+
+//----------------------------------------------------------------------
+// HostIO::Deliver
+// 	Schedule the interrupt of every watch found ready, at the next
+//	multiple of its interval.  The watch stays disarmed until the
+//	device Rearms it.
+//----------------------------------------------------------------------
+
+void
+HostIO::Deliver()
+{
+    pthread_mutex_lock(&mutex);
+    for (int i = 0; i < MaxHostWatches; i++) {
+	HostWatch *w = &watches[i];
+
+	if (!w->ready)
+	    continue;
+	w->ready = false;
+	__atomic_sub_fetch(&numArrivals, 1, __ATOMIC_RELEASE);
+	numDelivered++;
+	interrupt->Schedule(w->handler, w->arg,
+	    w->interval - (int) (stats->totalTicks % w->interval), w->type);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+//----------------------------------------------------------------------
+// HostIO::WaitForArrival
+// 	Called when the machine is idle and no interrupt is pending.
+//	Block the host until some watched descriptor has input, and
+//	schedule its interrupt.  Every IdleWaitSlice, print the accounting
+//	snapshot if SIGUSR1 asked for one, since no tick will.
+//
+//	Return false, without blocking, if no watch is waiting for input:
+//	then nothing will ever happen again.
+//----------------------------------------------------------------------
+
+bool
+HostIO::WaitForArrival()
+{
+    bool waiting = false;
+
+    pthread_mutex_lock(&mutex);
+    for (int i = 0; i < MaxHostWatches; i++)
+	if (watches[i].armed || watches[i].ready)
+	    waiting = true;
+    if (waiting) {
+	numIdleWaits++;
+	while (numArrivals == 0) {
+	    struct timespec until;
+
+	    clock_gettime(CLOCK_REALTIME, &until);
+	    until.tv_nsec += IdleWaitSlice;
+	    if (until.tv_nsec >= 1000000000L) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000L;
+	    }
+	    pthread_cond_timedwait(&arrived, &mutex, &until);
+	    if (numArrivals == 0) {
+		pthread_mutex_unlock(&mutex);
+		accounting->CheckSnapshot();
+		pthread_mutex_lock(&mutex);
+	    }
+	}
+    }
+    pthread_mutex_unlock(&mutex);
+
+    if (waiting)
+	Deliver();
+    return waiting;
+}
+
+//----------------------------------------------------------------------
+// HostIO::Loop
+// 	The host thread.  Wait in poll() on the wakeup pipe and every
+//	armed watch; disarm and mark ready each one that has input.
+//----------------------------------------------------------------------
+
+void
+HostIO::Loop()
+{
+    struct pollfd fds[MaxHostWatches + 1];
+    int which[MaxHostWatches + 1];
+    char drain[64];
+
+    pthread_mutex_lock(&mutex);
+    while (!stopping) {
+	int n = 0;
+
+	fds[n].fd = wakeFds[0];
+	fds[n].events = POLLIN;
+	n++;
+	for (int i = 0; i < MaxHostWatches; i++)
+	    if (watches[i].armed) {
+		fds[n].fd = watches[i].fd;
+		fds[n].events = POLLIN;
+		which[n] = i;
+		n++;
+	    }
+	pthread_mutex_unlock(&mutex);
+
+	int found = poll(fds, n, -1);
+
+	pthread_mutex_lock(&mutex);
+	if (found <= 0)				// interrupted, try again
+	    continue;
+	if (fds[0].revents != 0)
+	    while (read(wakeFds[0], drain, sizeof(drain)) > 0)
+		;
+	for (int k = 1; k < n; k++) {
+	    HostWatch *w = &watches[which[k]];
+
+	    if (fds[k].revents == 0 || !w->armed || w->fd != fds[k].fd)
+		continue;			// changed while we polled
+	    w->armed = false;
+	    w->ready = true;
+	    __atomic_add_fetch(&numArrivals, 1, __ATOMIC_RELEASE);
+	    pthread_cond_signal(&arrived);
+	}
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+//----------------------------------------------------------------------
+// HostIO::Print
+// 	Print the reactor statistics, at system shutdown.
+//----------------------------------------------------------------------
+
+void
+HostIO::Print()
+{
+    printf("Host I/O: %d arrivals delivered, %d idle waits\n",
+	numDelivered, numIdleWaits);
+}
@@ -0,0 +1,95 @@
+// hostio.h
+//	Data structures for the host I/O reactor.
+//
+//	The console and the network are simulated on top of UNIX files
+//	and sockets.  Rather than polling them every few simulated ticks
+//	(one select() each time, which almost always finds nothing), a
+//	device asks the reactor to Watch its descriptor.  A host thread
+//	waits in poll() on every watched descriptor, and marks the ones
+//	that become readable.  On its next tick, the simulation turns each
+//	arrival into the device's interrupt, at the next multiple of the
+//	device's poll interval -- the same grid of simulated times the
+//	polling used.
+//
+//	A watch fires once; the device Rearms it when it has room for
+//	more input.
+//
+//	When the machine is idle with no interrupts pending, it blocks in
+//	WaitForArrival until a device has input, instead of spinning
+//	through polls.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+
+#ifndef HOSTIO_H
+#define HOSTIO_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "interrupt.h"
+#include <pthread.h>
+
+// Number of descriptors that can be watched at once
+const int MaxHostWatches = 4;
+
+// The following class defines one watched descriptor.
+
+class HostWatch {
+  public:
+    int fd;			// UNIX descriptor to watch
+    VoidFunctionPtr handler;	// device interrupt for when it's readable
+    void* arg;			// argument to the interrupt handler
+    IntType type;		// for debugging
+    int interval;		// the interrupt comes at a multiple of this
+    bool inUse;			// is this entry a watch?
+    bool armed;			// is the host thread waiting on "fd"?
+    bool ready;			// did it find "fd" readable, and the
+				// simulation didn't see it yet?
+};
+
+// The following class defines the reactor.  The host thread only
+// touches the watches, under "mutex"; the simulation checks
+// "numArrivals" on every tick without taking it.
+
+class HostIO {
+  public:
+    HostIO();				// no watches, no host thread yet
+    ~HostIO();				// stop the host thread
+
+    int Watch(int fd, VoidFunctionPtr handler, void* arg, IntType type,
+	      int interval);		// call "handler" when "fd" has
+					// input; return the watch id
+    void Rearm(int watch);		// the device read the input, watch
+					// for more
+    void Unwatch(int watch);		// stop watching
+
+    void CheckArrivals()		// schedule the interrupts for any
+	{ if (__atomic_load_n(&numArrivals, __ATOMIC_ACQUIRE) > 0)
+	      Deliver(); }		// input; called on every tick
+    bool WaitForArrival();		// block until some input arrives;
+					// false if nothing is watched
+
+    void Print();			// Print the reactor statistics
+
+    void Loop();			// the host thread -- internal
+
+  private:
+    HostWatch watches[MaxHostWatches];
+    int numArrivals;			// watches ready, not yet delivered
+    bool started;			// is the host thread running?
+    bool stopping;			// should it exit?
+    pthread_t thread;
+    pthread_mutex_t mutex;		// protects the watches
+    pthread_cond_t arrived;		// signalled on each arrival
+    int wakeFds[2];			// pipe to wake up the host thread
+					// when the watches change
+
+    int numDelivered;			// arrivals turned into interrupts
+    int numIdleWaits;			// times the machine blocked idle
+
+    void Start();			// start the host thread
+    void Wake();			// make it look at the watches again
+    void Deliver();			// schedule the ready watches'
+					// interrupts
+};
+
+#endif // HOSTIO_H
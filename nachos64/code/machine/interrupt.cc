@@ -28,7 +28,8 @@
 
 static const char *intLevelNames[] = { "off", "on"};
 static const char *intTypeNames[] = { "timer", "disk", "console write", 
-				      "console read", "network send", "network recv"};
+				      "console read", "network send", "network recv",
+				      "alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -41,7 +42,7 @@ static const char *intTypeNames[] = { "timer", "disk", "console write",
 //	"kind" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
 
-PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void* param, int time, 
+PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void* param, long long time, 
 				IntType kind)
 {
     handler = func;
@@ -50,6 +51,23 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void* param, int time,
     type = kind;
 }
 
+//----------------------------------------------------------------------
+// SoftInterrupt::SoftInterrupt
+// 	Initialize the deferred work of an interrupt handler.  It runs
+//	each time the handler posts it.
+//
+//	"func" is the procedure to call, with interrupts enabled
+//	"param" is the argument to pass to the procedure
+//----------------------------------------------------------------------
+
+SoftInterrupt::SoftInterrupt(VoidFunctionPtr func, void* param)
+{
+    handler = func;
+    arg = param;
+    posted = false;
+    next = NULL;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Interrupt
 // 	Initialize the simulation of hardware device interrupts.
@@ -64,6 +82,12 @@ Interrupt::Interrupt()
     inHandler = false;
     yieldOnReturn = false;
     status = SystemMode;
+    softFirst = softLast = NULL;
+    inSoft = false;
+
+    offSince = 0;
+    numOff = numHandlers = numSoft = 0;
+    offTime = maxOff = handlerTime = maxHandler = softTime = 0;
 }
 
 //----------------------------------------------------------------------
@@ -105,6 +129,9 @@ Interrupt::ChangeLevel(IntStatus old, IntStatus now)
 // 	Change interrupts to be enabled or disabled, and if interrupts
 //	are being enabled, advance simulated time by calling OneTick().
 //
+//	Since simulated time stands still while interrupts are off, we
+//	measure how long the kernel keeps them off in host time.
+//
 // Returns:
 //	The old interrupt status.
 // Parameters:
@@ -121,8 +148,19 @@ Interrupt::SetLevel(IntStatus now)
 						// interrupts
 
     ChangeLevel(old, now);			// change to new state
-    if ((now == IntOn) && (old == IntOff))
+    if ((now == IntOff) && (old == IntOn))
+	offSince = HostNanoTime();
+    else if ((now == IntOn) && (old == IntOff)) {
+	if (offSince != 0) {
+	    long long off = HostNanoTime() - offSince;
+
+	    numOff++;
+	    offTime += off;
+	    if (off > maxOff)
+		maxOff = off;
+	}
 	OneTick();				// advance simulated time
+    }
     return old;
 }
 
@@ -146,6 +184,9 @@ Interrupt::Enable()
 //	Two things can cause OneTick to be called:
 //		interrupts are re-enabled
 //		a user instruction is executed
+//
+//	Once the handlers return, run the bottom halves they posted,
+//	before any context switch they asked for.
 //----------------------------------------------------------------------
 void
 Interrupt::OneTick()
@@ -160,7 +201,9 @@ Interrupt::OneTick()
 	stats->totalTicks += UserTick;
 	stats->userTicks += UserTick;
     }
-    DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
+    DEBUG('i', "\n== Tick %lld ==\n", stats->totalTicks);
+    accounting->CheckSnapshot();	// asked for with SIGUSR1
+    hostIO->CheckArrivals();		// device input, on the host
 
 // check any pending interrupts are now ready to fire
     ChangeLevel(IntOn, IntOff);		// first, turn off interrupts
@@ -169,8 +212,12 @@ Interrupt::OneTick()
     while (CheckIfDue(false))		// check for pending interrupts
 	;
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
-    if (yieldOnReturn) {		// if the timer device handler asked 
+    if (softFirst != NULL)		// deferred work of the handlers
+	RunSoft();
+    if (yieldOnReturn && !inSoft) {	// if the timer device handler asked 
 					// for a context switch, ok to do it now
+					// (but not in the middle of a
+					// bottom half)
 	yieldOnReturn = false;
  	status = SystemMode;		// yield is a kernel routine
 	currentThread->Yield();
@@ -178,6 +225,62 @@ Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::Post
+// 	Called from within an interrupt handler, to run "soft" once the
+//	handlers return, with interrupts enabled.  If "soft" is already
+//	posted, it runs only once.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Post(SoftInterrupt *soft)
+{
+    ASSERT(level == IntOff);
+    if (soft->posted)
+	return;
+    soft->posted = true;
+    soft->next = NULL;
+    if (softLast == NULL)
+	softFirst = soft;
+    else
+	softLast->next = soft;
+    softLast = soft;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::RunSoft
+// 	Run the bottom halves posted so far, and any they post in turn,
+//	in order.  A bottom half that enables interrupts can cause more
+//	handlers to run and post more work; that work waits for this
+//	loop, rather than nesting inside the bottom half.
+//----------------------------------------------------------------------
+
+void
+Interrupt::RunSoft()
+{
+    MachineStatus old = status;
+
+    if (inSoft)
+	return;
+    inSoft = true;
+    status = SystemMode;			// bottom halves are kernel code
+    while (softFirst != NULL) {
+	SoftInterrupt *soft = softFirst;
+
+	softFirst = soft->next;
+	if (softFirst == NULL)
+	    softLast = NULL;
+	soft->posted = false;
+
+	long long start = HostNanoTime();
+	(*(soft->handler))(soft->arg);
+	softTime += HostNanoTime() - start;
+	numSoft++;
+    }
+    status = old;
+    inSoft = false;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -204,28 +307,42 @@ Interrupt::YieldOnReturn()
 //	on the ready queue, the only thing to do is to advance 
 //	simulated time until the next scheduled hardware interrupt.
 //
-//	If there are no pending interrupts, stop.  There's nothing
-//	more for us to do.
+//	If there are no pending interrupts, wait on the host for input
+//	to the console or the network.  If there is no device to wait
+//	for either, stop.  There's nothing more for us to do.
+//
+//	Interrupts stay off while we are idle, but handlers run, so the
+//	time isn't counted as interrupts-off time.  The bottom halves the
+//	handlers posted run with interrupts enabled, as everywhere else.
 //----------------------------------------------------------------------
 void
 Interrupt::Idle()
 {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
+#ifdef USER_PROGRAM
+    consoleBuffer->Flush();		// a good time to show the output
+#endif
     status = IdleMode;
-    if (CheckIfDue(true)) {		// check for any pending interrupts
+    if (CheckIfDue(true)		// check for any pending interrupts
+	|| (hostIO->WaitForArrival() && CheckIfDue(true))) {
     	while (CheckIfDue(false))	// check for any other pending 
 	    ;				// interrupts
         yieldOnReturn = false;		// since there's nothing in the
 					// ready queue, the yield is automatic
         status = SystemMode;
+	ChangeLevel(IntOff, IntOn);	// bottom halves run with interrupts
+	RunSoft();			// on, as after OneTick; probably
+	ChangeLevel(IntOn, IntOff);	// readies a thread
+	if (offSince != 0)
+	    offSince = HostNanoTime();
 	return;				// return in case there's now
 					// a runnable thread
     }
 
     // if there are no pending interrupts, and nothing is on the ready
     // queue, it is time to stop.   If the console or the network is 
-    // operating, there are *always* pending interrupts, so this code
-    // is not reached.  Instead, the halt must be invoked by the user program.
+    // waiting for input, we wait for it instead, so this code is not
+    // reached.  Instead, the halt must be invoked by the user program.
 
     DEBUG('i', "Machine idle.  No interrupts to do.\n");
     printf("No threads ready or runnable, and no pending interrupts.\n");
@@ -240,6 +357,9 @@ Interrupt::Idle()
 void
 Interrupt::Halt()
 {
+#ifdef USER_PROGRAM
+    consoleBuffer->Flush();		// user output before the statistics
+#endif
     printf("Machine halting!\n\n");
     stats->Print();
     Cleanup();     // Never returns.
@@ -264,10 +384,10 @@ Interrupt::Halt()
 void
 Interrupt::Schedule(VoidFunctionPtr handler, void* arg, int fromNow, IntType type)
 {
-    int when = stats->totalTicks + fromNow;
+    long long when = stats->totalTicks + fromNow;
     PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
 
-    DEBUG('i', "Scheduling interrupt handler the %s at time = %d\n", 
+    DEBUG('i', "Scheduling interrupt handler the %s at time = %lld\n", 
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
@@ -291,7 +411,7 @@ bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
-    int when;
+    long long when;
 
     ASSERT(level == IntOff);		// interrupts need to be disabled,
 					// to invoke an interrupt handler
@@ -318,7 +438,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 	 return false;
     }
 
-    DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
+    DEBUG('i', "Invoking interrupt handler for the %s at time %lld\n", 
 			intTypeNames[toOccur->type], toOccur->when);
 #ifdef USER_PROGRAM
     if (machine != NULL)
@@ -328,13 +448,37 @@ Interrupt::CheckIfDue(bool advanceClock)
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
 						// running in the kernel
+    long long start = HostNanoTime();
     (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
+    long long spent = HostNanoTime() - start;
     status = old;				// restore the machine status
     inHandler = false;
+
+    numHandlers++;
+    handlerTime += spent;
+    if (spent > maxHandler)
+	maxHandler = spent;
     delete toOccur;
     return true;
 }
 
+//----------------------------------------------------------------------
+// Interrupt::PrintStats
+// 	Print how long the kernel kept interrupts off, and how long the
+//	interrupt handlers and their bottom halves took, in host time.
+//----------------------------------------------------------------------
+
+void
+Interrupt::PrintStats()
+{
+    printf("Interrupts off: %d times, %lld ns each, %lld ns at most\n",
+	numOff, (numOff > 0) ? offTime / numOff : 0, maxOff);
+    printf("Interrupt handlers: %d, %lld ns each, %lld ns at most; "
+	"bottom halves: %d, %lld ns each\n", numHandlers,
+	(numHandlers > 0) ? handlerTime / numHandlers : 0, maxHandler,
+	numSoft, (numSoft > 0) ? softTime / numSoft : 0);
+}
+
 //----------------------------------------------------------------------
 // PrintPending
 // 	Print information about an interrupt that is scheduled to occur.
@@ -344,7 +488,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 static void
 PrintPending(PendingInterrupt* pend)
 {
-    printf("Interrupt handler %s, scheduled at %d\n", 
+    printf("Interrupt handler %s, scheduled at %lld\n", 
            intTypeNames[pend->type], pend->when);
 }
 
@@ -357,7 +501,7 @@ PrintPending(PendingInterrupt* pend)
 void
 Interrupt::DumpState()
 {
-    printf("Time: %d, interrupts %s\n", stats->totalTicks, 
+    printf("Time: %lld, interrupts %s\n", stats->totalTicks, 
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
@@ -26,6 +26,13 @@
 //	always detect when your program would fail in real life, does not 
 //	mean it's ok to write incorrectly synchronized code!)
 //
+//	An interrupt handler (the "top half") should only acknowledge the
+//	device, and Post the rest of its work as a SoftInterrupt (the
+//	"bottom half").  Bottom halves run as soon as the handlers return,
+//	with interrupts enabled, so the kernel's interrupts-off time
+//	doesn't grow with the work the devices need.  Like handlers, they
+//	must not block.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -48,9 +55,11 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  AlarmInt is the one-shot
+// interrupt the kernel alarm clock arms for its next wakeup; unlike
+// TimerInt, it counts as pending work when the machine is idle.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, AlarmInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -58,17 +67,34 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 
 class PendingInterrupt {
   public:
-    PendingInterrupt(VoidFunctionPtr func, void* param, int time, IntType kind);
+    PendingInterrupt(VoidFunctionPtr func, void* param, long long time,
+		     IntType kind);
 				// initialize an interrupt that will
 				// occur in the future
 
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     void* arg;                  // The argument to the function.
-    int when;			// When the interrupt is supposed to fire
+    long long when;		// When the interrupt is supposed to fire
     IntType type;		// for debugging
 };
 
+// The following class defines the deferred work of an interrupt
+// handler.  A device driver owns one per kind of event, and posts it
+// from its handler; posting it again before it runs does nothing, the
+// bottom half must look at the device to see how much work there is.
+
+class SoftInterrupt {
+  public:
+    SoftInterrupt(VoidFunctionPtr func, void* param);
+				// initialize deferred work, not yet posted
+
+    VoidFunctionPtr handler;    // The function to call, with interrupts on
+    void* arg;                  // The argument to the function.
+    bool posted;		// Is it waiting to run?
+    SoftInterrupt *next;	// The next posted one
+};
+
 // The following class defines the data structures for the simulation
 // of hardware interrupts.  We record whether interrupts are enabled
 // or disabled, and any hardware interrupts that are scheduled to occur
@@ -99,7 +125,10 @@ class Interrupt {
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState();			// Print interrupt state
-    
+    void PrintStats();			// Print how long interrupts were off
+
+    void Post(SoftInterrupt *soft);	// Run "soft" once the interrupt
+					// handlers return; called by them
 
     // NOTE: the following are internal to the hardware simulation code.
     // DO NOT call these directly.  I should make them "private",
@@ -121,6 +150,21 @@ class Interrupt {
 				// on return from the interrupt handler
     MachineStatus status;	// idle, kernel mode, user mode
 
+    SoftInterrupt *softFirst;	// bottom halves posted, not yet run,
+    SoftInterrupt *softLast;	// in the order they were posted
+    bool inSoft;		// true if we are running bottom halves
+
+    long long offSince;		// host time the kernel last turned
+				// interrupts off, 0 before it ever did
+    int numOff;			// times the kernel turned them off
+    long long offTime;		// host nanoseconds they were off
+    long long maxOff;		// the longest time they were off
+    int numHandlers;		// interrupt handlers run
+    long long handlerTime;	// host nanoseconds spent in them
+    long long maxHandler;	// the longest one
+    int numSoft;		// bottom halves run
+    long long softTime;		// host nanoseconds spent in them
+
     // these functions are internal to the interrupt simulation code
 
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
@@ -128,6 +172,8 @@ class Interrupt {
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 	IntStatus now);  		// simulated time
+
+    void RunSoft();			// Run the posted bottom halves
 };
 
 #endif // INTERRRUPT_H
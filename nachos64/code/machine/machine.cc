@@ -56,8 +56,7 @@ Machine::Machine(bool debug)
 {
     int i;
 
-    for (i = 0; i < NumTotalRegs; i++)
-        registers[i] = 0;
+    registers = NULL;			// until a thread's set is loaded
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
@@ -71,6 +70,8 @@ Machine::Machine(bool debug)
     pageTable = NULL;
 #endif
 
+    linked = false;
+    linkedAddress = 0;
     singleStep = debug;
     CheckEndian();
 }
@@ -107,6 +108,7 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
 
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
+    linked = false;			// the kernel may run other threads
     DelayedLoad(0, 0);			// finish anything in progress
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
@@ -130,7 +132,7 @@ void Machine::Debugger()
 
     interrupt->DumpState();
     DumpState();
-    printf("%d> ", stats->totalTicks);
+    printf("%lld> ", stats->totalTicks);
     fflush(stdout);
     fgets(buf, 80, stdin);
     if (sscanf(buf, "%d", &num) == 1)
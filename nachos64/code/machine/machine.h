@@ -133,8 +133,15 @@ class Machine {
     				// Read or write 1, 2, or 4 bytes of virtual
 				// memory (at addr).  Return false if a
 				// correct translation couldn't be found.
-	  void SafeReadMem(int addr, int size, int* value);
-		void SafeWriteMem(int addr, int size, int value);
+    bool SafeReadMem(int addr, int size, int* value);
+    bool SafeWriteMem(int addr, int size, int value);
+    bool SafeReadBlock(int addr, int size, char* into);
+    bool SafeWriteBlock(int addr, int size, const char* from);
+    				// Copy "size" bytes between virtual memory
+				// and a kernel buffer, a page at a time,
+				// taking any page faults on the way.
+				// Return false if the range is not in
+				// the current address space.
 
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
     				// Translate an address, and check for
@@ -159,7 +166,11 @@ class Machine {
 
     char *mainMemory;		// physical memory to store user program,
 				// code and data, while executing
-    int registers[NumTotalRegs]; // CPU registers, for executing user programs
+    int *registers;		// CPU registers, for executing user programs;
+				// the register set of the running thread,
+				// switched by Thread::RestoreUserState
+    bool linked;		// an LL is waiting for its SC (the LLbit)
+    int linkedAddress;		// address given to that LL
 
 
 // NOTE: the hardware translation of virtual addresses in the user program
@@ -33,7 +33,7 @@ Machine::Run()
     Instruction *instr = new Instruction;  // storage for decoded instruction
 
     if(DebugIsEnabled('m'))
-        printf("Starting thread \"%s\" at time %d\n",
+        printf("Starting thread \"%s\" at time %lld\n",
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
     for (;;) {
@@ -277,6 +277,22 @@ Machine::OneInstruction(Instruction *instr)
 	nextLoadValue = value;
 	break;
     	
+      case OP_LL:
+	// Load linked: a load, that also starts an atomic sequence on
+	// "tmp", that the next SC completes if nothing got in between
+	tmp = registers[(int)instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->ReadMem(tmp, 4, &value))
+	    return;
+	linked = true;
+	linkedAddress = tmp;
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	break;
+
       case OP_LWL:	  
 	tmp = registers[(int)instr->rs] + instr->extra;
 
@@ -468,6 +484,23 @@ Machine::OneInstruction(Instruction *instr)
 	registers[(int)instr->rd] = registers[(int)instr->rs] - registers[(int)instr->rt];
 	break;
 	
+      case OP_SC:
+	// Store conditional: store only if no trap or context switch
+	// happened since the LL on the same address; rt tells if it did
+	tmp = registers[(int)instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (linked && linkedAddress == tmp) {
+	    if (!machine->WriteMem((unsigned) tmp, 4, registers[(int)instr->rt]))
+		return;			// the fault broke the link, try again
+	    registers[(int)instr->rt] = 1;
+	} else
+	    registers[(int)instr->rt] = 0;
+	linked = false;
+	break;
+
       case OP_SW:
 	if (!machine->WriteMem((unsigned) 
 		(registers[(int)instr->rs] + instr->extra), 4, registers[(int)instr->rt]))
@@ -41,31 +41,26 @@ Network::Network(NetworkAddress addr, double reliability,
     AssignNameToSocket(sockName, sock);		 // Bind socket to a filename 
 						 // in the current directory.
 
-    // start polling for incoming packets
-    interrupt->Schedule(NetworkReadPoll, this, NetworkTime, NetworkRecvInt);
+    // interrupt when a packet arrives, on a poll boundary
+    recvWatch = hostIO->Watch(sock, NetworkReadPoll, this, NetworkRecvInt,
+			      NetworkTime);
 }
 
 Network::~Network()
 {
+    hostIO->Unwatch(recvWatch);
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
 
-// if a packet is already buffered, we simply delay reading 
-// the incoming packet.  In real life, the incoming 
+// called when a packet can be read.  Once a packet is buffered,
+// the host I/O reactor stops watching until Receive takes it,
+// delaying the next incoming packet.  In real life, the incoming 
 // packet might be dropped if we can't read it in time.
 void
 Network::CheckPktAvail()
 {
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(NetworkReadPoll, this, NetworkTime, NetworkRecvInt);
-
-    if (inHdr.length != 0) 	// do nothing if packet is already buffered
-	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
-
-    // otherwise, read packet in
+    // read packet in
     char *buffer = new char[MaxWireSize];
     ReadFromSocket(sock, buffer, MaxWireSize);
 
@@ -132,5 +127,6 @@ Network::Receive(char* data)
     inHdr.length = 0;
     if (hdr.length != 0)
     	bcopy(inbox, data, hdr.length);
+    hostIO->Rearm(recvWatch);	// the buffer is free, watch again
     return hdr;
 }
@@ -95,6 +95,8 @@ class Network {
     bool packetAvail;		// Packet has arrived, can be pulled off of
 				//   network
     PacketHeader inHdr;		// Information about arrived packet
+    int recvWatch;		// Host I/O watch on "sock"; disarmed
+				//   while a packet is buffered
     char inbox[MaxPacketSize];  // Data for arrived packet
 };
 
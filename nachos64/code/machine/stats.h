@@ -18,13 +18,14 @@
 // many user instructions executed, etc.
 //
 // The fields in this class are public to make it easier to update.
+// Time is kept in 64 bits, so that long runs don't overflow it.
 
 class Statistics {
   public:
-    int totalTicks;      	// Total time running Nachos
-    int idleTicks;       	// Time spent idle (no threads to run)
-    int systemTicks;	 	// Time spent executing system code
-    int userTicks;       	// Time spent executing user code
+    long long totalTicks;      	// Total time running Nachos
+    long long idleTicks;       	// Time spent idle (no threads to run)
+    long long systemTicks;	// Time spent executing system code
+    long long userTicks;       	// Time spent executing user code
 				// (this is also equal to # of
 				// user instructions executed)
 
@@ -34,9 +34,8 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
-#ifdef HOST_i386
 #include <sys/time.h>
-#endif
+#include <time.h>
 #ifdef HOST_LINUX
 #include <sys/syscall.h>
 #include <unistd.h>
@@ -364,6 +363,20 @@ CallOnUserAbort(VoidNoArgFunctionPtr func)
     (void)signal(SIGINT, (SignalHandler) func);
 }
 
+//----------------------------------------------------------------------
+// CallOnUserSignal
+// 	Arrange that "func" will be called when the user sends the
+//	process SIGUSR1 (e.g., with "kill -USR1").  Unlike ctl-C, this
+//	doesn't stop anything, so "func" should only set a flag.
+//----------------------------------------------------------------------
+
+void 
+CallOnUserSignal(VoidNoArgFunctionPtr func)
+{
+    typedef void (*SignalHandler) (int);
+    (void)signal(SIGUSR1, (SignalHandler) func);
+}
+
 //----------------------------------------------------------------------
 // Sleep
 // 	Put the UNIX process running Nachos to sleep for x seconds,
@@ -399,6 +412,37 @@ Exit(int exitCode)
     exit(exitCode);
 }
 
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the host wall clock time, in microseconds.  Used to measure
+//	how long the simulator itself takes to do something, as opposed
+//	to simulated time.
+//----------------------------------------------------------------------
+
+long long
+HostTime()
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (long long) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+//----------------------------------------------------------------------
+// HostNanoTime
+// 	Return the host monotonic clock, in nanoseconds.  Like HostTime,
+//	but fine enough to time a single context switch.
+//----------------------------------------------------------------------
+
+long long
+HostNanoTime()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
 //----------------------------------------------------------------------
 // RandomInit
 // 	Initialize the pseudo-random number generator.  We use the
@@ -46,6 +46,16 @@ extern void Delay(int seconds);
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 
+// Arrange for "func" to be called when the user sends SIGUSR1, to ask
+// a running simulation for a report
+extern void CallOnUserSignal(VoidNoArgFunctionPtr func);
+
+// Host wall clock, in microseconds, for measuring the simulator itself
+extern long long HostTime();
+
+// Host monotonic clock, in nanoseconds, for measuring very short intervals
+extern long long HostNanoTime();
+
 // Initialize the pseudo random number generator
 extern void RandomInit(unsigned seed);
 extern int Random();
@@ -46,24 +46,61 @@ Timer::Timer(VoidFunctionPtr timerHandler, void* callArg, bool doRandom)
     randomize = doRandom;
     handler = timerHandler;
     arg = callArg; 
+    running = true;
 
     // schedule the first interrupt from the timer device
     interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(), 
 		TimerInt); 
+    pending = true;
+}
+
+//----------------------------------------------------------------------
+// Timer::Start
+//      Resume generating an interrupt every time slice, after Stop.
+//	If the interrupt scheduled before Stop hasn't happened yet, it
+//	is the next one; simulated interrupts can't be taken back.
+//----------------------------------------------------------------------
+
+void
+Timer::Start()
+{
+    running = true;
+    if (!pending) {
+	interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(),
+		TimerInt);
+	pending = true;
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Stop
+//      Stop generating interrupts, until Start is called.  An interrupt
+//	already scheduled still happens, but doesn't reach the handler.
+//----------------------------------------------------------------------
+
+void
+Timer::Stop()
+{
+    running = false;
 }
 
 //----------------------------------------------------------------------
 // Timer::TimerExpired
 //      Routine to simulate the interrupt generated by the hardware 
 //	timer device.  Schedule the next interrupt, and invoke the
-//	interrupt handler.
+//	interrupt handler -- unless the timer was stopped.
 //----------------------------------------------------------------------
 void 
 Timer::TimerExpired() 
 {
+    pending = false;
+    if (!running)
+	return;
+
     // schedule the next timer device interrupt
     interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(), 
 		TimerInt);
+    pending = true;
 
     // invoke the Nachos interrupt handler for this device
     (*handler)(arg);
@@ -31,6 +31,12 @@ class Timer {
 				// handler "timerHandler" every time slice.
     ~Timer() {}
 
+    void Start();		// interrupt every time slice again, if
+				// stopped
+    void Stop();		// no more interrupts until Start; one
+				// already scheduled is ignored
+    bool IsRunning() { return running; }
+
 // Internal routines to the timer emulation -- DO NOT call these
 
     void TimerExpired();	// called internally when the hardware
@@ -43,6 +49,8 @@ class Timer {
     bool randomize;		// set if we need to use a random timeout delay
     VoidFunctionPtr handler;	// timer interrupt handler 
     void* arg;			// argument to pass to interrupt handler
+    bool running;		// does the handler want interrupts?
+    bool pending;		// is an interrupt scheduled?
 
 };
 
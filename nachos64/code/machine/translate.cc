@@ -121,9 +121,41 @@ Machine::ReadMem(int addr, int size, int *value)
     return true;
 }
 
-void  Machine::SafeReadMem(int addr, int size, int* value){
-	while(!ReadMem(addr, size, value));
-	return;
+//----------------------------------------------------------------------
+// InAddressSpace
+//	Return true if the "size" bytes at "addr" are in the pages of the
+//	current address space.  A page fault on any other address can't be
+//	served, so the Safe routines check before trying.
+//----------------------------------------------------------------------
+
+static bool
+InAddressSpace(int addr, int size)
+{
+    AddrSpace *space = currentThread->space;
+
+    if (space == NULL || addr < 0 || size <= 0)
+	return false;
+    return ((unsigned) addr + (unsigned) size - 1) / PageSize
+	< space->numPages;
+}
+
+//----------------------------------------------------------------------
+// Machine::SafeReadMem
+//	Like ReadMem, but page faults are served and the read tried
+//	again.  Returns false, with "*value" set to 0, if "addr" is not
+//	in the current address space.
+//----------------------------------------------------------------------
+
+bool
+Machine::SafeReadMem(int addr, int size, int* value)
+{
+    if (!InAddressSpace(addr, size)) {
+	*value = 0;
+	return false;
+    }
+    while (!ReadMem(addr, size, value))
+	;
+    return true;
 }
 
 //----------------------------------------------------------------------
@@ -173,9 +205,94 @@ Machine::WriteMem(int addr, int size, int value)
     return true;
 }
 
-void Machine::SafeWriteMem(int addr, int size, int value){
-	while(!WriteMem(addr, size, value));
-	return;
+//----------------------------------------------------------------------
+// Machine::SafeWriteMem
+//	Like WriteMem, but page faults are served and the write tried
+//	again.  Returns false if "addr" is not in the current address
+//	space.
+//----------------------------------------------------------------------
+
+bool
+Machine::SafeWriteMem(int addr, int size, int value)
+{
+    if (!InAddressSpace(addr, size))
+	return false;
+    while (!WriteMem(addr, size, value))
+	;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Machine::SafeReadBlock, Machine::SafeWriteBlock
+//      Copy "size" bytes between virtual memory at location "addr" and
+//	the kernel buffer "into" (or "from").  The address is translated
+//	once per page, and each page is copied with a single memcpy,
+//	instead of going through ReadMem or WriteMem a byte at a time.
+//
+//	As with SafeReadMem, a page fault is served and the page tried
+//	again.  Returns false, having copied only part of the block, if
+//	the block is not all in the current address space, or a page
+//	can't be accessed (e.g., writing a read-only page).
+//----------------------------------------------------------------------
+
+bool
+Machine::SafeReadBlock(int addr, int size, char* into)
+{
+    ExceptionType exception;
+    int physicalAddress;
+
+    DEBUG('a', "Reading block at VA 0x%x, size %d\n", addr, size);
+    if (size == 0)
+	return true;
+    if (!InAddressSpace(addr, size))
+	return false;
+    while (size > 0) {
+	int count = PageSize - (addr % PageSize);	// rest of this page
+	if (count > size)
+	    count = size;
+	exception = Translate(addr, &physicalAddress, 1, false);
+	if (exception == PageFaultException) {
+	    machine->RaiseException(exception, addr);
+	    continue;
+	}
+	if (exception != NoException)
+	    return false;
+	memcpy(into, &machine->mainMemory[physicalAddress], count);
+	addr += count;
+	into += count;
+	size -= count;
+    }
+    return true;
+}
+
+bool
+Machine::SafeWriteBlock(int addr, int size, const char* from)
+{
+    ExceptionType exception;
+    int physicalAddress;
+
+    DEBUG('a', "Writing block at VA 0x%x, size %d\n", addr, size);
+    if (size == 0)
+	return true;
+    if (!InAddressSpace(addr, size))
+	return false;
+    while (size > 0) {
+	int count = PageSize - (addr % PageSize);	// rest of this page
+	if (count > size)
+	    count = size;
+	exception = Translate(addr, &physicalAddress, 1, true);
+	if (exception == PageFaultException) {
+	    machine->RaiseException(exception, addr);
+	    continue;
+	}
+	if (exception != NoException)
+	    return false;
+	memcpy(&machine->mainMemory[physicalAddress], from, count);
+	addr += count;
+	from += count;
+	size -= count;
+    }
+    return true;
 }
 
 //----------------------------------------------------------------------
@@ -18,6 +18,7 @@
 
 #include "copyright.h"
 #include "post.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // Mail::Mail
@@ -152,6 +153,15 @@ static void ReadAvail(void* arg)
 static void WriteDone(void* arg)
 { PostOffice* po = (PostOffice *) arg; po->PacketSent(); }
 
+//----------------------------------------------------------------------
+// SemaphoreV
+// 	Bottom half of the network interrupts: wake up the thread waiting
+//	on semaphore "arg", with interrupts enabled.
+//----------------------------------------------------------------------
+
+static void SemaphoreV(void* arg)
+{ Semaphore* semaphore = (Semaphore *) arg; semaphore->V(); }
+
 //----------------------------------------------------------------------
 // PostOffice::PostOffice
 // 	Initialize a post office as a collection of mailboxes.
@@ -176,6 +186,8 @@ PostOffice::PostOffice(NetworkAddress addr, double reliability, int nBoxes)
 // First, initialize the synchronization with the interrupt handlers
     messageAvailable = new Semaphore("message available", 0);
     messageSent = new Semaphore("message sent", 0);
+    packetArrived = new SoftInterrupt(SemaphoreV, messageAvailable);
+    packetSent = new SoftInterrupt(SemaphoreV, messageSent);
     sendLock = new Lock("message send lock");
 
 // Second, initialize the mailboxes
@@ -205,6 +217,8 @@ PostOffice::~PostOffice()
     delete [] boxes;
     delete messageAvailable;
     delete messageSent;
+    delete packetArrived;
+    delete packetSent;
     delete sendLock;
 }
 
@@ -318,12 +332,13 @@ PostOffice::Receive(int box, PacketHeader *pktHdr,
 // 	Interrupt handler, called when a packet arrives from the network.
 //
 //	Signal the PostalDelivery routine that it is time to get to work!
+//	(once the handler returns)
 //----------------------------------------------------------------------
 
 void
 PostOffice::IncomingPacket()
 { 
-    messageAvailable->V(); 
+    interrupt->Post(packetArrived); 
 }
 
 //----------------------------------------------------------------------
@@ -339,6 +354,6 @@ PostOffice::IncomingPacket()
 void 
 PostOffice::PacketSent()
 { 
-    messageSent->V();
+    interrupt->Post(packetSent);
 }
 
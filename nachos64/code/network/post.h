@@ -31,6 +31,8 @@
 #include "network.h"
 #include "synchlist.h"
 
+class SoftInterrupt;
+
 // Mailbox address -- uniquely identifies a mailbox on a given machine.
 // A mailbox is just a place for temporary storage for messages.
 typedef int MailBoxAddress;
@@ -135,6 +137,8 @@ class PostOffice {
     int numBoxes;		// Number of mail boxes
     Semaphore *messageAvailable;// V'ed when message has arrived from network
     Semaphore *messageSent;	// V'ed when next message can be sent to network
+    SoftInterrupt *packetArrived;	// bottom halves of the interrupt
+    SoftInterrupt *packetSent;	//   handlers, V the semaphores
     Lock *sendLock;		// Only one outgoing message at a time
 };
 
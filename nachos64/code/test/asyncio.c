@@ -0,0 +1,41 @@
+/* asyncio.c
+ *	Test program for asynchronous I/O: writes a file with WriteAsync,
+ *	waiting with WaitIO, then reads it back with ReadAsync, waiting on
+ *	the completion semaphore first.
+ *
+ *	Exits with the number of bytes read back (26), or -1 if they
+ *	don't match what was written.
+ */
+
+#include "syscall.h"
+
+char out[] = "abcdefghijklmnopqrstuvwxyz";
+char in[64];
+
+int
+main()
+{
+    OpenFileId file;
+    int request, sem, n, i;
+
+    Create("async.dat");
+    file = Open("async.dat");
+    request = WriteAsync(out, 26, file, -1);
+    if (request < 0 || WaitIO(request) != 26)
+	Exit(-1);
+    Close(file);
+
+    file = Open("async.dat");
+    sem = SemCreate(0);
+    request = ReadAsync(in, sizeof(in), file, sem);
+    if (request < 0)
+	Exit(-1);
+    SemWait(sem);			/* signaled when the read is done */
+    n = WaitIO(request);
+    for (i = 0; i < n; i++)
+	if (in[i] != out[i])
+	    Exit(-1);
+    SemDestroy(sem);
+    Close(file);
+    Exit(n);
+}
@@ -0,0 +1,26 @@
+/* join.c
+ *	Test program for Join: runs matmult, and gets its exit status
+ *	back with Join.  A second Join of the same program, and a Join of
+ *	a program that was never Exec'd, have to fail.
+ *
+ *	Exits with the status of matmult (7220), or -1.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    SpaceId child;
+    int status;
+
+    child = Exec("../test/matmult");
+    if (child < 0)
+	Exit(-1);
+    status = Join(child);
+    if (Join(child) != -1)		/* only once */
+	Exit(-1);
+    if (Join(child + 100) != -1)	/* not a child of ours */
+	Exit(-1);
+    Exit(status);
+}
@@ -0,0 +1,33 @@
+/* pipe.c
+ *	Test program for pipes: data written to one end comes out of the
+ *	other, a Read of 0 bytes doesn't block, and a Read sees end of file
+ *	once the write end is closed.
+ *
+ *	Exits with the number of bytes that went through the pipe (5),
+ *	or -1.
+ */
+
+#include "syscall.h"
+
+char buffer[16];
+
+int
+main()
+{
+    OpenFileId ends[2];
+    int n;
+
+    if (Pipe(ends) < 0)
+	Exit(-1);
+    Write("hello", 5, ends[1]);
+    if (Read(buffer, 0, ends[0]) != 0)
+	Exit(-1);
+    n = Read(buffer, sizeof(buffer), ends[0]);
+    if (n != 5 || buffer[0] != 'h' || buffer[4] != 'o')
+	Exit(-1);
+    Close(ends[1]);
+    if (Read(buffer, sizeof(buffer), ends[0]) != 0)	/* end of file */
+	Exit(-1);
+    Close(ends[0]);
+    Exit(n);
+}
@@ -0,0 +1,42 @@
+/* seek.c
+ *	Test program for positional I/O: Seek, PRead and PWrite on a
+ *	small file.  PRead and PWrite must not move the position that
+ *	Read and Seek use.
+ *
+ *	Exits with 0, or with the number of the first check that failed.
+ */
+
+#include "syscall.h"
+
+char buffer[16];
+
+int
+main()
+{
+    OpenFileId file;
+
+    Create("seek.dat");
+    file = Open("seek.dat");
+    Write("0123456789", 10, file);
+
+    if (Seek(file, 2, SeekSet) != 2)
+	Exit(1);
+    if (Read(buffer, 3, file) != 3 || buffer[0] != '2' || buffer[2] != '4')
+	Exit(2);
+    if (PRead(buffer, 2, file, 8) != 2 || buffer[0] != '8' || buffer[1] != '9')
+	Exit(3);
+    if (Read(buffer, 1, file) != 1 || buffer[0] != '5')	/* still at 5 */
+	Exit(4);
+    if (PWrite("X", 1, file, 0) != 1)
+	Exit(5);
+    if (Seek(file, 0, SeekEnd) != 10)
+	Exit(6);
+    if (Seek(file, -10, SeekCur) != 0)
+	Exit(7);
+    if (Read(buffer, 1, file) != 1 || buffer[0] != 'X')
+	Exit(8);
+    if (Seek(ConsoleInput, 0, SeekSet) != -1)		/* not the console */
+	Exit(9);
+    Close(file);
+    Exit(0);
+}
@@ -0,0 +1,50 @@
+/* semfast.c
+ *	Several threads of one process contend on a single FutexSem,
+ *	used as a lock around a shared counter.  Each one yields while it
+ *	holds the lock, so the others pile up in SemFastWait and go
+ *	through FutexWait/FutexWake.
+ *
+ *	Exits with the final count, Threads * Rounds (500), if no update
+ *	got lost.
+ */
+
+#include "syscall.h"
+
+#define Threads	5
+#define Rounds	100
+
+FutexSem mutex;
+int counter;
+int done;
+
+void
+worker(int dummy)
+{
+    int i, c;
+
+    for (i = 0; i < Rounds; i++) {
+	SemFastWait(&mutex);
+	c = counter;
+	Yield();
+	counter = c + 1;
+	SemFastSignal(&mutex);
+    }
+    SemFastWait(&mutex);
+    done++;
+    SemFastSignal(&mutex);
+}
+
+int
+main()
+{
+    int i;
+
+    mutex.count = 1;
+    mutex.waiters = 0;
+    for (i = 1; i < Threads; i++)
+	Fork(worker);
+    worker(0);
+    while (done < Threads)
+	Yield();
+    Exit(counter);
+}
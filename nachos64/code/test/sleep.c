@@ -0,0 +1,20 @@
+/* sleep.c
+ *	Test program for Sleep: sleeps a few times.  Nothing else is
+ *	running, so the machine should skip ahead to each wakeup instead
+ *	of ticking through the sleep.
+ *
+ *	Exits with the number of sleeps that returned 0 (5).
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    int i, slept = 0;
+
+    for (i = 0; i < 5; i++)
+	if (Sleep(1000) == 0)
+	    slept++;
+    Exit(slept);
+}
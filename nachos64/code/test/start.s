@@ -162,6 +162,210 @@ SemWait:
 	j	$31
 	.end SemWait
 
+	.globl Mmap
+	.ent	Mmap
+Mmap:
+	addiu $2,$0,SC_Mmap
+	syscall
+	j	$31
+	.end Mmap
+
+	.globl Munmap
+	.ent	Munmap
+Munmap:
+	addiu $2,$0,SC_Munmap
+	syscall
+	j	$31
+	.end Munmap
+
+	.globl SubmitBatch
+	.ent	SubmitBatch
+SubmitBatch:
+	addiu $2,$0,SC_SubmitBatch
+	syscall
+	j	$31
+	.end SubmitBatch
+
+	.globl ReadAsync
+	.ent	ReadAsync
+ReadAsync:
+	addiu $2,$0,SC_ReadAsync
+	syscall
+	j	$31
+	.end ReadAsync
+
+	.globl WriteAsync
+	.ent	WriteAsync
+WriteAsync:
+	addiu $2,$0,SC_WriteAsync
+	syscall
+	j	$31
+	.end WriteAsync
+
+	.globl WaitIO
+	.ent	WaitIO
+WaitIO:
+	addiu $2,$0,SC_WaitIO
+	syscall
+	j	$31
+	.end WaitIO
+
+	.globl Seek
+	.ent	Seek
+Seek:
+	addiu $2,$0,SC_Seek
+	syscall
+	j	$31
+	.end Seek
+
+	.globl PRead
+	.ent	PRead
+PRead:
+	addiu $2,$0,SC_PRead
+	syscall
+	j	$31
+	.end PRead
+
+	.globl PWrite
+	.ent	PWrite
+PWrite:
+	addiu $2,$0,SC_PWrite
+	syscall
+	j	$31
+	.end PWrite
+
+	.globl FutexWait
+	.ent	FutexWait
+FutexWait:
+	addiu $2,$0,SC_FutexWait
+	syscall
+	j	$31
+	.end FutexWait
+
+	.globl FutexWake
+	.ent	FutexWake
+FutexWake:
+	addiu $2,$0,SC_FutexWake
+	syscall
+	j	$31
+	.end FutexWake
+
+	.globl Pipe
+	.ent	Pipe
+Pipe:
+	addiu $2,$0,SC_Pipe
+	syscall
+	j	$31
+	.end Pipe
+
+	.globl ShmCreate
+	.ent	ShmCreate
+ShmCreate:
+	addiu $2,$0,SC_ShmCreate
+	syscall
+	j	$31
+	.end ShmCreate
+
+	.globl ShmAttach
+	.ent	ShmAttach
+ShmAttach:
+	addiu $2,$0,SC_ShmAttach
+	syscall
+	j	$31
+	.end ShmAttach
+
+	.globl ShmDetach
+	.ent	ShmDetach
+ShmDetach:
+	addiu $2,$0,SC_ShmDetach
+	syscall
+	j	$31
+	.end ShmDetach
+
+	.globl SetPriority
+	.ent	SetPriority
+SetPriority:
+	addiu $2,$0,SC_SetPriority
+	syscall
+	j	$31
+	.end SetPriority
+
+	.globl GetPriority
+	.ent	GetPriority
+GetPriority:
+	addiu $2,$0,SC_GetPriority
+	syscall
+	j	$31
+	.end GetPriority
+
+	.globl Sleep
+	.ent	Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
+/* -------------------------------------------------------------
+ * SemFastWait, SemFastSignal
+ *	The user half of a FutexSem (see syscall.h).  The counter is
+ *	changed with LL/SC, so the kernel is only entered, through
+ *	FutexWait and FutexWake, to sleep or to wake up a sleeper.
+ *	A system call leaves every register but r2 alone, so "sem"
+ *	is still in r4 after it.
+ *	Under mips2 the assembler puts no delay slots after loads, but
+ *	the simulator still delays them one instruction, hence the nops.
+ * -------------------------------------------------------------
+ */
+	.set	mips2
+
+	.globl SemFastWait
+	.ent	SemFastWait
+SemFastWait:
+	ll	$8,0($4)		/* take one from count, if any */
+	nop
+	blez	$8,1f
+	addiu	$8,$8,-1
+	sc	$8,0($4)
+	beq	$8,$0,SemFastWait	/* someone got in, try again */
+	move	$2,$0
+	j	$31
+1:	ll	$8,4($4)		/* count is 0: waiters++ */
+	nop
+	addiu	$8,$8,1
+	sc	$8,4($4)
+	beq	$8,$0,1b
+	move	$5,$0			/* FutexWait(&sem->count, 0) */
+	addiu	$2,$0,SC_FutexWait
+	syscall
+2:	ll	$8,4($4)		/* waiters-- */
+	nop
+	addiu	$8,$8,-1
+	sc	$8,4($4)
+	beq	$8,$0,2b
+	j	SemFastWait
+	.end SemFastWait
+
+	.globl SemFastSignal
+	.ent	SemFastSignal
+SemFastSignal:
+	ll	$8,0($4)		/* count++ */
+	nop
+	addiu	$8,$8,1
+	sc	$8,0($4)
+	beq	$8,$0,SemFastSignal
+	lw	$8,4($4)		/* wake a sleeper, if any */
+	nop
+	blez	$8,1f
+	addiu	$5,$0,1			/* FutexWake(&sem->count, 1) */
+	addiu	$2,$0,SC_FutexWake
+	syscall
+1:	move	$2,$0
+	j	$31
+	.end SemFastSignal
+
+	.set	mips0
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
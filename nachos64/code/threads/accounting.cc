@@ -0,0 +1,333 @@
+// accounting.cc 
+//	Routines to charge threads and address spaces for what they use,
+//	and to report it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "accounting.h"
+#include "system.h"
+
+static const char *threadStatusNames[] = { "new", "running", "ready",
+					   "blocked" };
+
+//----------------------------------------------------------------------
+// SpaceAccountOf
+// 	Return the account of the address space "thread" runs in, or
+//	NULL if it only runs in the kernel.
+//----------------------------------------------------------------------
+
+static Account *
+SpaceAccountOf(Thread *thread)
+{
+#ifdef USER_PROGRAM
+    if (thread->space != NULL)
+	return thread->space->account;
+#endif
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Account::Account
+// 	Initialize an account with nothing used yet.
+//----------------------------------------------------------------------
+
+Account::Account(int accountId, AccountKind accountKind,
+		 const char *accountName)
+{
+    id = accountId;
+    kind = accountKind;
+    name = new char[strlen(accountName) + 1];
+    strcpy(name, accountName);
+    thread = NULL;
+    live = true;
+    userTicks = systemTicks = blockedTicks = 0;
+    syscalls = faults = switches = 0;
+    next = prev = NULL;
+}
+
+Account::~Account()
+{
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// Accounting::Accounting
+// 	Initialize an empty set of accounts.
+//
+//	"reportName" is the file to write the JSON report to, at halt;
+//	NULL for no report.
+//----------------------------------------------------------------------
+
+Accounting::Accounting(const char *reportName)
+{
+    accounts = lastAccount = NULL;
+    numAccounts = 0;
+    fileName = NULL;
+    if (reportName != NULL) {
+	fileName = new char[strlen(reportName) + 1];
+	strcpy(fileName, reportName);
+    }
+    lastUserTicks = lastSystemTicks = 0;
+    snapshotRequested = 0;
+}
+
+Accounting::~Accounting()
+{
+    while (accounts != NULL) {
+	Account *account = accounts;
+	accounts = account->next;
+	delete account;
+    }
+    delete [] fileName;
+}
+
+//----------------------------------------------------------------------
+// Accounting::Open
+// 	Return a new account, for a thread or an address space called
+//	"name".  "thread" is the thread, for a thread account.
+//----------------------------------------------------------------------
+
+Account *
+Accounting::Open(AccountKind kind, const char *name, Thread *thread)
+{
+    Account *account = new Account(numAccounts++, kind, name);
+
+    account->thread = thread;
+    account->prev = lastAccount;
+    if (lastAccount == NULL)
+	accounts = account;
+    else
+	lastAccount->next = account;
+    lastAccount = account;
+    return account;
+}
+
+//----------------------------------------------------------------------
+// Accounting::Close
+// 	The owner of "account" is being deleted.  Keep the account if it
+//	is needed for the report, and otherwise free it.  Does nothing if
+//	"account" is NULL (it was already closed).
+//----------------------------------------------------------------------
+
+void
+Accounting::Close(Account *account)
+{
+    if (account == NULL)
+	return;
+    account->live = false;
+    account->thread = NULL;
+    if (fileName != NULL)
+	return;
+
+    if (account->prev == NULL)
+	accounts = account->next;
+    else
+	account->prev->next = account->next;
+    if (account->next == NULL)
+	lastAccount = account->prev;
+    else
+	account->next->prev = account->prev;
+    delete account;
+}
+
+//----------------------------------------------------------------------
+// Accounting::ChargeRunning
+// 	Charge "thread", which is running, and its address space, for the
+//	user and system ticks since the last charge.  Called when the
+//	scheduler charges the running thread, so when it yields, blocks
+//	or is interrupted by the timer.
+//----------------------------------------------------------------------
+
+void
+Accounting::ChargeRunning(Thread *thread)
+{
+    long long user = stats->userTicks - lastUserTicks;
+    long long system = stats->systemTicks - lastSystemTicks;
+    Account *space = SpaceAccountOf(thread);
+
+    thread->account->userTicks += user;
+    thread->account->systemTicks += system;
+    if (space != NULL) {
+	space->userTicks += user;
+	space->systemTicks += system;
+    }
+    lastUserTicks = stats->userTicks;
+    lastSystemTicks = stats->systemTicks;
+}
+
+//----------------------------------------------------------------------
+// Accounting::Dispatched
+// 	A thread starts to run; it is only charged from now on.
+//----------------------------------------------------------------------
+
+void
+Accounting::Dispatched()
+{
+    lastUserTicks = stats->userTicks;
+    lastSystemTicks = stats->systemTicks;
+}
+
+//----------------------------------------------------------------------
+// Accounting::Switched, Woken, CountSyscall, CountFault
+// 	Count an event against a thread and its address space.
+//----------------------------------------------------------------------
+
+void
+Accounting::Switched(Thread *thread)
+{
+    Account *space = SpaceAccountOf(thread);
+
+    thread->account->switches++;
+    if (space != NULL)
+	space->switches++;
+}
+
+void
+Accounting::Woken(Thread *thread, long long ticks)
+{
+    Account *space = SpaceAccountOf(thread);
+
+    thread->account->blockedTicks += ticks;
+    if (space != NULL)
+	space->blockedTicks += ticks;
+}
+
+void
+Accounting::CountSyscall()
+{
+    Account *space = SpaceAccountOf(currentThread);
+
+    currentThread->account->syscalls++;
+    if (space != NULL)
+	space->syscalls++;
+}
+
+void
+Accounting::CountFault()
+{
+    Account *space = SpaceAccountOf(currentThread);
+
+    currentThread->account->faults++;
+    if (space != NULL)
+	space->faults++;
+}
+
+//----------------------------------------------------------------------
+// Accounting::PrintSnapshot
+// 	Print the AccountSnapshotSize live accounts that used the most
+//	CPU, like "top".  The running thread is charged first, so its
+//	line is up to date.
+//----------------------------------------------------------------------
+
+void
+Accounting::PrintSnapshot()
+{
+    Account *shown[AccountSnapshotSize];
+    int numShown = 0;
+
+    snapshotRequested = 0;
+    ChargeRunning(currentThread);
+
+    // pick the busiest, by insertion into a short sorted list
+    for (Account *account = accounts; account != NULL;
+	 account = account->next) {
+	if (!account->live)
+	    continue;
+	long long used = account->userTicks + account->systemTicks;
+	int i = numShown;
+	if (i == AccountSnapshotSize) {
+	    Account *last = shown[i - 1];
+	    if (used <= last->userTicks + last->systemTicks)
+		continue;
+	    i--;
+	} else
+	    numShown++;
+	for (; i > 0 && used > shown[i - 1]->userTicks
+				+ shown[i - 1]->systemTicks; i--)
+	    shown[i] = shown[i - 1];
+	shown[i] = account;
+    }
+
+    printf("\nSnapshot at tick %lld: user %lld, system %lld, idle %lld\n",
+	stats->totalTicks, stats->userTicks, stats->systemTicks,
+	stats->idleTicks);
+    printf("%5s %-6s %-8s %10s %10s %10s %8s %6s %8s  %s\n", "ID", "KIND",
+	"STATE", "USER", "SYSTEM", "BLOCKED", "SYSCALLS", "FAULTS",
+	"SWITCHES", "NAME");
+    for (int i = 0; i < numShown; i++) {
+	Account *account = shown[i];
+	printf("%5d %-6s %-8s %10lld %10lld %10lld %8d %6d %8d  %s\n",
+	    account->id,
+	    (account->kind == ThreadAccount) ? "thread" : "space",
+	    (account->thread != NULL) ?
+		threadStatusNames[account->thread->getStatus()] : "",
+	    account->userTicks, account->systemTicks, account->blockedTicks,
+	    account->syscalls, account->faults, account->switches,
+	    account->name);
+    }
+    fflush(stdout);
+}
+
+//----------------------------------------------------------------------
+// WriteAccounts
+// 	Write every account of kind "kind" as a JSON array.
+//----------------------------------------------------------------------
+
+static void
+WriteAccounts(FILE *out, Account *accounts, AccountKind kind)
+{
+    bool first = true;
+
+    fprintf(out, "[");
+    for (Account *account = accounts; account != NULL;
+	 account = account->next) {
+	if (account->kind != kind)
+	    continue;
+	fprintf(out, "%s\n    {\"id\": %d, \"name\": ", first ? "" : ",",
+		account->id);
+	WriteJSONString(out, account->name);
+	fprintf(out, ", \"live\": %s, "
+		"\"user_ticks\": %lld, \"system_ticks\": %lld, "
+		"\"blocked_ticks\": %lld, \"syscalls\": %d, \"faults\": %d, "
+		"\"switches\": %d}", account->live ? "true" : "false",
+		account->userTicks, account->systemTicks,
+		account->blockedTicks, account->syscalls, account->faults,
+		account->switches);
+	first = false;
+    }
+    fprintf(out, "\n  ]");
+}
+
+//----------------------------------------------------------------------
+// Accounting::WriteReport
+// 	Write every account, live or not, to the report file as JSON.
+//	Does nothing if no report was asked for.
+//----------------------------------------------------------------------
+
+void
+Accounting::WriteReport()
+{
+    FILE *out;
+
+    if (fileName == NULL)
+	return;
+    out = fopen(fileName, "w");
+    if (out == NULL) {
+	perror("Unable to write the accounting report");
+	return;
+    }
+    ChargeRunning(currentThread);
+
+    fprintf(out, "{\n  \"ticks\": {\"total\": %lld, \"idle\": %lld, "
+	    "\"system\": %lld, \"user\": %lld},\n", stats->totalTicks,
+	    stats->idleTicks, stats->systemTicks, stats->userTicks);
+    fprintf(out, "  \"threads\": ");
+    WriteAccounts(out, accounts, ThreadAccount);
+    fprintf(out, ",\n  \"spaces\": ");
+    WriteAccounts(out, accounts, SpaceAccount);
+    fprintf(out, "\n}\n");
+    fclose(out);
+}
@@ -0,0 +1,106 @@
+// accounting.h 
+//	Data structures to account for the resources used by each thread
+//	and each user address space.
+//
+//	Every thread, and every address space, gets an account when it is
+//	created.  The account keeps the user and system ticks it ran, the
+//	ticks it spent blocked, and how many system calls, page faults and
+//	context switches it made.  Ticks are charged when the thread stops
+//	running, from the global counters in "stats", so nothing is done
+//	on each tick.  A thread's usage is also charged to its address
+//	space, if it has one.
+//
+//	When a JSON report was asked for, accounts outlive their thread or
+//	address space, so the report written at halt covers everything
+//	that ever ran; otherwise an account is freed when its owner is
+//	gone.  A "top"-like snapshot of the live ones can be asked for at
+//	any time, with a host signal; it is printed on the next tick (or
+//	while the machine waits idle for input), so the simulation goes on
+//	undisturbed.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ACCOUNTING_H
+#define ACCOUNTING_H
+
+#include "copyright.h"
+#include "utility.h"
+#include <signal.h>
+
+class Thread;
+
+enum AccountKind { ThreadAccount, SpaceAccount };
+
+// Number of accounts in a snapshot
+const int AccountSnapshotSize = 20;
+
+// The following class defines the usage of one thread or address space.
+
+class Account {
+  public:
+    Account(int accountId, AccountKind accountKind, const char *accountName);
+    ~Account();
+
+    int id;				// order of creation
+    AccountKind kind;
+    char *name;				// copied, for after the owner is gone
+    Thread *thread;			// a thread account's thread, while
+					// it exists
+    bool live;				// its owner still exists
+
+    long long userTicks;		// ticks running user code
+    long long systemTicks;		// ticks running in the kernel
+    long long blockedTicks;		// ticks spent asleep
+    int syscalls;			// system calls made
+    int faults;				// page faults taken
+    int switches;			// times it gave up the CPU
+
+    Account *next;			// all accounts, in order of creation
+    Account *prev;
+};
+
+// The following class defines the set of all accounts.
+
+class Accounting {
+  public:
+    Accounting(const char *reportName);	// JSON report goes to "reportName",
+					// if not NULL
+    ~Accounting();
+
+    Account *Open(AccountKind kind, const char *name, Thread *thread);
+					// A new account for a thread or
+					// address space
+    void Close(Account *account);	// Its owner is gone; the owner
+					// must forget "account"
+
+    void ChargeRunning(Thread *thread);	// Charge the ticks "thread" ran
+					// since it was last charged
+    void Dispatched();			// A thread starts to run
+    void Switched(Thread *thread);	// "thread" gave up the CPU
+    void Woken(Thread *thread, long long ticks);	// "thread" woke up
+					// after sleeping for "ticks"
+    void CountSyscall();		// The current thread made a
+    void CountFault();			// system call, or took a fault
+
+    void RequestSnapshot() { snapshotRequested = 1; }
+					// Safe to call from a signal handler
+    void CheckSnapshot() { if (snapshotRequested) PrintSnapshot(); }
+					// Print the snapshot, if asked for
+    void PrintSnapshot();		// Print the busiest live accounts
+    void WriteReport();			// Write the JSON report, if any
+
+  private:
+    Account *accounts;			// all accounts, in order
+    Account *lastAccount;		// of creation
+    int numAccounts;
+    char *fileName;			// where the report goes, or NULL
+
+    long long lastUserTicks;		// global counters when the running
+    long long lastSystemTicks;		// thread was last charged
+    volatile sig_atomic_t snapshotRequested;	// set by the signal
+					// handler
+};
+
+#endif // ACCOUNTING_H
@@ -0,0 +1,231 @@
+// alarm.cc 
+//	Routines to put threads to sleep for a while, and to wake them
+//	up when their time comes.
+//
+//	All the routines run with interrupts disabled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// AlarmInterruptHandler
+// 	Called when the armed interrupt goes off.  Dummy function because
+//	C++ does not allow a pointer to a member function.
+//----------------------------------------------------------------------
+
+static void
+AlarmInterruptHandler(void* arg)
+{
+    ((Alarm *) arg)->Expired();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize an alarm clock with nobody sleeping.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+    for (int level = 0; level < AlarmLevels; level++)
+	for (int slot = 0; slot < AlarmSlots; slot++)
+	    slots[level][slot] = NULL;
+    overflow = NULL;
+    numSleeping = 0;
+    current = 0;
+    armedAt = -1;
+    numWaits = numCascades = 0;
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+// 	Put the current thread to sleep until simulated time "when".
+//	It is off the ready list meanwhile; if nothing else can run, the
+//	machine idles until the wakeup.  Returns right away if "when"
+//	has already passed.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(long long when)
+{
+    AlarmEntry entry;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (when > stats->totalTicks) {
+	DEBUG('t', "Thread \"%s\" sleeps until %lld\n",
+	      currentThread->getName(), when);
+	Advance(stats->totalTicks);	// file it relative to now
+	entry.when = when;
+	entry.thread = currentThread;
+	Insert(&entry);
+	numWaits++;
+	Arm();
+	currentThread->Sleep();
+    }
+    interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Insert
+// 	File "entry" at the lowest level whose span around the current
+//	time contains its wakeup time.  An entry that is already due
+//	goes to the current level 0 slot, and fires on the next Advance.
+//----------------------------------------------------------------------
+
+void
+Alarm::Insert(AlarmEntry* entry)
+{
+    long long when = (entry->when > current) ? entry->when : current;
+
+    numSleeping++;
+    for (int level = 0; level < AlarmLevels; level++) {
+	int span = AlarmLevelBits * (level + 1);
+	if ((when >> span) == (current >> span)) {
+	    AlarmEntry** slot =
+		&slots[level][(when >> (AlarmLevelBits * level)) & (AlarmSlots - 1)];
+	    entry->next = *slot;
+	    *slot = entry;
+	    return;
+	}
+    }
+    entry->next = overflow;
+    overflow = entry;
+}
+
+//----------------------------------------------------------------------
+// Alarm::NextEvent
+// 	Return the time of the next slot that needs handling, and which
+//	slot it is, or -1 if nobody is sleeping.  Level 0 slots are due
+//	at their own tick; higher level slots are cascaded when time
+//	reaches their start.  Lower levels always come first, since they
+//	only hold times before the next slot of the level above.
+//
+//	"level" is set to AlarmLevels for the overflow list.
+//----------------------------------------------------------------------
+
+long long
+Alarm::NextEvent(int* level, int* slot)
+{
+    if (numSleeping == 0)
+	return -1;
+
+    for (int l = 0; l < AlarmLevels; l++) {
+	int shift = AlarmLevelBits * l;
+	int first = ((current >> shift) & (AlarmSlots - 1)) + (l > 0 ? 1 : 0);
+	for (int s = first; s < AlarmSlots; s++) {
+	    if (slots[l][s] != NULL) {
+		*level = l;
+		*slot = s;
+		return ((current >> (shift + AlarmLevelBits))
+			<< (shift + AlarmLevelBits)) | (s << shift);
+	    }
+	}
+    }
+    ASSERT(overflow != NULL);
+    *level = AlarmLevels;
+    *slot = 0;
+    return ((current >> (AlarmLevelBits * AlarmLevels)) + 1)
+	    << (AlarmLevelBits * AlarmLevels);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Advance
+// 	Bring the wheel up to time "now": wake up every thread whose time
+//	has come, and cascade every higher level slot whose start has been
+//	reached.
+//----------------------------------------------------------------------
+
+void
+Alarm::Advance(long long now)
+{
+    int level, slot;
+    long long when;
+
+    while ((when = NextEvent(&level, &slot)) != -1 && when <= now) {
+	AlarmEntry* entry;
+	current = when;
+	if (level == AlarmLevels) {
+	    entry = overflow;
+	    overflow = NULL;
+	} else {
+	    entry = slots[level][slot];
+	    slots[level][slot] = NULL;
+	}
+
+	if (level == 0) {		// their time has come
+	    while (entry != NULL) {
+		AlarmEntry* next = entry->next;	// "entry" is on the sleeper's
+		numSleeping--;			// stack, read it first
+		DEBUG('t', "Waking up thread \"%s\" at %lld\n",
+		      entry->thread->getName(), now);
+		scheduler->ReadyToRun(entry->thread);
+		entry = next;
+	    }
+	} else {			// file them again, closer to now
+	    numCascades++;
+	    while (entry != NULL) {
+		AlarmEntry* next = entry->next;
+		numSleeping--;
+		Insert(entry);
+		entry = next;
+	    }
+	}
+    }
+    if (now > current)
+	current = now;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Arm
+// 	Make sure an interrupt is armed for the next slot that needs
+//	handling.  The interrupt can't be taken back, so one that is
+//	armed for a later time is left to go off harmlessly.
+//----------------------------------------------------------------------
+
+void
+Alarm::Arm()
+{
+    int level, slot;
+    long long when = NextEvent(&level, &slot);
+
+    if (when == -1 || (armedAt != -1 && armedAt <= when))
+	return;
+    if (when <= stats->totalTicks)
+	when = stats->totalTicks + 1;
+    interrupt->Schedule(AlarmInterruptHandler, this,
+			when - stats->totalTicks, AlarmInt);
+    armedAt = when;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Expired
+// 	An armed interrupt went off: wake up whoever is due, and arm the
+//	next one.
+//----------------------------------------------------------------------
+
+void
+Alarm::Expired()
+{
+    if (armedAt != -1 && armedAt <= stats->totalTicks)
+	armedAt = -1;
+    Advance(stats->totalTicks);
+    Arm();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Print
+// 	Print the alarm statistics, if any thread ever slept.
+//----------------------------------------------------------------------
+
+void
+Alarm::Print()
+{
+    if (numWaits == 0)
+	return;
+    printf("Alarm: %d sleeps, %d cascades, %d still sleeping\n",
+	numWaits, numCascades, numSleeping);
+}
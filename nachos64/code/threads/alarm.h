@@ -0,0 +1,74 @@
+// alarm.h 
+//	Data structures for a software alarm clock, to let threads sleep
+//	until some point in simulated time.
+//
+//	Sleeping threads are kept in a hierarchical timing wheel: level 0
+//	has one slot per tick, level 1 one slot per 64 ticks, and so on,
+//	each level covering the span of one slot of the level above.  A
+//	wakeup is filed at the lowest level whose span, around the current
+//	time, contains it.  As time reaches the start of a higher level
+//	slot, its entries cascade down one or more levels; level 0 slots
+//	are fired.  Inserting and firing a wakeup take constant time.
+//
+//	Only one hardware interrupt is kept armed, for the next slot that
+//	needs attention, so while every thread sleeps Interrupt::Idle
+//	jumps straight there instead of running the clock tick by tick.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "thread.h"
+
+// Shape of the timing wheel
+const int AlarmLevelBits = 6;
+const int AlarmSlots = 1 << AlarmLevelBits;	// slots per level
+const int AlarmLevels = 4;			// levels; wakeups further
+						// away wait on an overflow list
+
+// The following class defines one sleeping thread.  It lives on the
+// sleeper's stack, for as long as it sleeps.
+
+class AlarmEntry {
+  public:
+    long long when;			// tick to wake up at
+    Thread* thread;			// who to wake up
+    AlarmEntry* next;			// next entry in the same slot
+};
+
+// The following class defines the alarm clock.
+
+class Alarm {
+  public:
+    Alarm();				// Initialize an empty wheel
+    ~Alarm() {}
+
+    void WaitUntil(long long when);	// Put the current thread to sleep
+					// until stats->totalTicks >= "when"
+    void Print();			// Print the alarm statistics
+
+    void Expired();			// The armed interrupt went off;
+					// internal to the alarm clock
+
+  private:
+    AlarmEntry* slots[AlarmLevels][AlarmSlots];	// the wheel
+    AlarmEntry* overflow;		// wakeups past the top level
+    int numSleeping;			// entries in the wheel
+    long long current;			// time the wheel has advanced to
+    long long armedAt;			// time of the armed interrupt, or -1
+
+    int numWaits;			// threads put to sleep
+    int numCascades;			// slots cascaded to a lower level
+
+    void Insert(AlarmEntry* entry);	// file "entry" in the wheel
+    long long NextEvent(int* level, int* slot);	// next slot to handle
+    void Advance(long long now);	// handle every slot up to "now"
+    void Arm();				// make sure the next slot is armed
+};
+
+#endif // ALARM_H
@@ -24,11 +24,11 @@
 template <class Item>
 class ListElement {
    public:
-     ListElement(Item itemPtr, int sortKey);	// initialize a list element
+     ListElement(Item itemPtr, long long sortKey);	// initialize a list element
 
      ListElement *next;		// next element on list, 
 				// NULL if this is the last
-     int key;		    	// priority, for a sorted list
+     long long key;	    	// priority, for a sorted list
      Item item; 	    	// item on the list
 };
 
@@ -54,8 +54,8 @@ class List {
     
 
     // Routines to put/get items on/off list in order (sorted by key)
-    void SortedInsert(Item item, int sortKey);	// Put item into list
-    Item SortedRemove(int *keyPtr); 	  	// Remove first item from list
+    void SortedInsert(Item item, long long sortKey);	// Put item into list
+    Item SortedRemove(long long *keyPtr); 	  	// Remove first item from list
 
   private:
     typedef ListElement<Item> ListNode;
@@ -72,7 +72,7 @@ class List {
 //----------------------------------------------------------------------
 
 template <class Item>
-ListElement<Item>::ListElement(Item anItem, int sortKey)
+ListElement<Item>::ListElement(Item anItem, long long sortKey)
 {
      item = anItem;
      key = sortKey;
@@ -228,7 +228,7 @@ List<Item>::IsEmpty()
 
 template <class Item>
 void
-List<Item>::SortedInsert(Item item, int sortKey)
+List<Item>::SortedInsert(Item item, long long sortKey)
 {
     ListNode *element = new ListNode(item, sortKey);
     ListNode *ptr;		// keep track
@@ -268,7 +268,7 @@ List<Item>::SortedInsert(Item item, int sortKey)
 
 template <class Item>
 Item
-List<Item>::SortedRemove(int *keyPtr)
+List<Item>::SortedRemove(long long *keyPtr)
 {
     ListNode *element = first;
 
@@ -8,7 +8,8 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
+// Usage: nachos -d <debugflags> -rs <random seed #> -sp <fifo|mlfq> -pt
+//		-ss <stack words> -lp -ac [report file]
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
@@ -18,13 +19,33 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -sp selects the scheduling policy: the original FIFO ready list,
+//        or the multi-level feedback queue (the default)
+//    -pt keeps the timer interrupting every time slice, even when no
+//        other thread is ready to run
+//    -ss sets the size of kernel thread stacks, in words
+//    -lp profiles contention on semaphores, locks and conditions, and
+//        prints the most contended ones at halt
+//    -ac writes what each thread and address space used, as JSON, at
+//        halt (optionally followed by the report file, accounting.json
+//        by default).  "kill -USR1" prints a snapshot at any time.
+//    -p preempts kernel threads at arbitrary points (optionally followed
+//        by the time slice, in microseconds of host CPU time)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
+//    -ec sets how many pages of program code and data are kept in
+//        memory, to launch the same programs again without reading them
 //    -c tests the console
 //
+//  VM
+//    -cs keeps evicted pages compressed in memory, in front of the swap
+//        file (optionally followed by the pool size in bytes)
+//    -fr writes a JSON report of every page fault, by cause, at halt
+//        (optionally followed by the report file, faults.json by default)
+//
 //  FILESYS
 //    -f causes the physical disk to be formatted
 //    -cp copies a file from UNIX to Nachos
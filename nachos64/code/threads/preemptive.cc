@@ -1,6 +1,17 @@
 // preemptive.cc 
 //	Extension to make kernel threads be periodically preempted
-//      It only works on Linux x86 environments
+//      at arbitrary points, driven by a host interval timer
+//
+//	The time slice is measured with ITIMER_VIRTUAL, in host CPU time
+//	used by Nachos.  When it expires, SIGVTALRM interrupts whatever
+//	kernel code is running, and the signal handler makes the current
+//	thread Yield, right there, as if the code had called Yield itself.
+//	The handler runs on the interrupted thread's stack, so it simply
+//	returns once the thread is scheduled again.
+//
+//	The kernel used to be single stepped by a ptrace'd monitor process
+//	that counted host instructions, which is exact but stops Nachos on
+//	every instruction; a timer only costs one signal per time slice.
 //
 // Copyright (c) 2007 Universidad de Las Palmas de Gran Canaria
 //
@@ -14,158 +25,81 @@
 // access to global object: currentThread, interrupt...
 #include "system.h"
 
-// UNIX and Linux-specific headers
-#include <unistd.h>
-#include <sys/ptrace.h>
-#include <sys/wait.h>
-#include <sys/user.h>
+// UNIX-specific headers
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
 
-static void ContextSwitch ();
-static void MonitorProcess ( int childPid, unsigned long timeSliceLength );
-static void LetMeBeMonitored ();
+static void ContextSwitch ( int sig );
+static void SetTimer ( unsigned long timeSliceLength );
 
-static bool inContextSwitch = false;
+static volatile bool inContextSwitch = false;
 
 // Set up the preemptive scheduler
-// The 'timeSliceLength' argument means how many machine instructions
-// will last the time slice for every kernel thread
+// The 'timeSliceLength' argument means how many microseconds of
+// host CPU time will last the time slice for every kernel thread
 
 void PreemptiveScheduler::SetUp ( unsigned long timeSliceLength )
 {
-  int  childPid = fork();
-  switch ( childPid ) {
-    case -1:
-      DEBUG ( 'p', "Preemptive scheduler: unable to launch child process\n" );
-      ASSERT (false);
-      break;
-    
-    // child process: original Nachos code
-    case 0:
-      LetMeBeMonitored ();
-      // resumes Nachos execution as a child process
-      return;
-    
-    // parent process: monitor code
-    default:
-      MonitorProcess ( childPid, timeSliceLength );
-    } // end of switch
+  struct sigaction action;
+
+  memset ( &action, 0, sizeof(action) );
+  action.sa_handler = ContextSwitch;
+  sigemptyset ( &action.sa_mask );
+  // The handler may switch to another thread and not return for a
+  // while: don't keep the signal blocked meanwhile, and restart the
+  // host system calls it interrupts
+  action.sa_flags = SA_NODEFER | SA_RESTART;
+  if ( sigaction ( SIGVTALRM, &action, NULL ) != 0 ) {
+    DEBUG ( 'p', "Preemptive scheduler: unable to install the handler\n" );
+    ASSERT (false);
+  }
+
+  SetTimer ( timeSliceLength );
+  DEBUG ( 'p', "Preemptive scheduler: time slice of %lu us\n",
+          timeSliceLength );
 }
 
+// Stop the time slicing
 
-void LetMeBeMonitored ()
+PreemptiveScheduler::~PreemptiveScheduler()
 {
-  // allow the parent process to ptrace me
-  ptrace ( PTRACE_TRACEME, 0, NULL, NULL );
-  
-  DEBUG ( 'p', "Preemptive scheduler: child process will be ptraced\n" );
-  
-  // Raise a signal to bring back control to the parent
-  raise(SIGUSR1);
+  SetTimer ( 0 );
+  signal ( SIGVTALRM, SIG_IGN );
 }
 
+// Arm the interval timer, or disarm it if 'timeSliceLength' is 0
 
-void MonitorProcess ( int childPid, unsigned long timeSliceLength )
+static void SetTimer ( unsigned long timeSliceLength )
 {
-  // machine instruction counter
-  long long instructionCounter = 1;
-  
-  while (true) {
-    
-    // Wait for child process
-    int wait_val;
-    wait (&wait_val);
-    if ( WIFEXITED(wait_val) ) {
-      DEBUG ( 'p', "Preemptive scheduler: child process terminated\n" );
-      break;
-    }
-
-    // Increment instruction counter
-    instructionCounter++;
-    
-    // From time to time, insert machine code to force a context switch
-    if ( instructionCounter % timeSliceLength == 0 )
-    {
-      // Get child value of 'inContextSwitch'
-      long incs = ptrace ( PTRACE_PEEKDATA, childPid, (long)&inContextSwitch, NULL );
-      
-      if ( incs == 0 ) { 
-        DEBUG ( 'p', "Preemptive scheduler: "
-                     "forcing a context switch at instruction %lld\n",
-                     instructionCounter );
-                     
-        struct user_regs_struct regs;
-        
-        // Get child process registers
-        ptrace ( PTRACE_GETREGS,  childPid, NULL, &regs );
-
-	// build a call stack frame by inserting EIP/RIP on top of the stack
-#ifdef HOST_i386        
-        regs.esp = regs.esp - 4;
-        ptrace ( PTRACE_POKEDATA, childPid, regs.esp, regs.eip );
-        // force a jump to ContextSwitch()
-        regs.eip = (long) ContextSwitch;
-#elif defined(HOST_x86_64)
-        regs.rsp = regs.rsp - 8;
-        ptrace ( PTRACE_POKEDATA, childPid, regs.rsp, regs.rip );
-        // force a jump to ContextSwitch()
-        regs.rip = (long long) ContextSwitch;
-#endif
-
-        // Store new register values in the child process
-        // The child will now make a call to ContextSwitch()
-        ptrace ( PTRACE_SETREGS, childPid, NULL, &regs );
-      }
-    }
-    
-    // Resume child execution
-    ptrace( PTRACE_SINGLESTEP, childPid, NULL, NULL );
-  }
+  struct itimerval slice;
 
-  DEBUG ( 'p', "Preemptive scheduler: Finished\n" );
-  exit(0);
+  slice.it_interval.tv_sec = timeSliceLength / 1000000;
+  slice.it_interval.tv_usec = timeSliceLength % 1000000;
+  slice.it_value = slice.it_interval;
+  setitimer ( ITIMER_VIRTUAL, &slice, NULL );
 }
 
 
 // Force a context switch
-// This call is made asynchronously from the
-// parent process, using ptrace() features
+// This is the SIGVTALRM handler, so it is called asynchronously,
+// at any point of the kernel code
 
-static void ContextSwitch (void)
+static void ContextSwitch ( int sig )
 {
-  // prevent register loss: save all registers
-#ifdef HOST_i386        
-  __asm__ ("pushal");
-  __asm__ ("subl $8, %esp");
-#elif defined(HOST_x86_64)
-  // push all registers
-  __asm__ ("push %rax; push %rbx; push %rcx; push %rdx");
-  __asm__ ("push %rsi; push %rdi; push %rsp; push %rbp");
-  __asm__ ("push %r8; push %r9; push %r10; push %r11; push %r12; push %r13; push %r14; push %r15");
-  __asm__ ("sub $16, %rsp");
-#endif
-  
+  // a previous slice is still being handled
+  if ( inContextSwitch )
+    return;
+
   inContextSwitch = true;
   
   // make a context switch if interrupts are enabled
   if ( interrupt->getLevel() == IntOn ) {
+    DEBUG ( 'p', "Preemptive scheduler: forcing a context switch\n" );
     inContextSwitch = false;
     currentThread->Yield();
   } else {
     interrupt->YieldOnReturn();
     inContextSwitch = false;
   }
-  
-  // restore old register values
-#ifdef HOST_i386        
-  __asm__ ("addl $8, %esp");
-  __asm__ ("popal");
-#elif defined(HOST_x86_64)
-  __asm__ ("add $16, %rsp");
-  // pop all registers
-  __asm__ ("pop %r15; pop %r14; pop %r13; pop %r12; pop %r11; pop %r10; pop %r9; pop %r8");
-  __asm__ ("pop %rbp; pop %rsp; pop %rdi; pop %rsi");
-  __asm__ ( "pop %rdx; pop %rcx; pop %rbx; pop %rax" );
-#endif
-
 }
-
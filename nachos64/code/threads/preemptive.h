@@ -1,6 +1,6 @@
-// preemptive.cc 
+// preemptive.h 
 //	Extension to make kernel threads be periodically preempted
-//      It only works on Linux x86 environments
+//      at arbitrary points, driven by a host interval timer
 //
 // Copyright (c) 2007 Universidad de Las Palmas de Gran Canaria
 //
@@ -16,11 +16,11 @@ class PreemptiveScheduler
 {
   public:
     PreemptiveScheduler() {}
-    ~PreemptiveScheduler() {}
+    ~PreemptiveScheduler();		// stop the time slicing
     
     // Set up time slicing between kernel threads.
     //   'timeSliceLength' is the time slice duration,
-    //   measured in native x86 machine instructions
+    //   measured in microseconds of host CPU time
     
     void SetUp ( unsigned long timeSliceLength );
 };
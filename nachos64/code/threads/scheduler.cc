@@ -11,8 +11,9 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	The order of the ready threads is left to a SchedulingPolicy;
+//	the scheduler charges CPU time to the running thread and tells
+//	the policy when threads become ready.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -22,30 +23,247 @@
 #include "scheduler.h"
 #include "system.h"
 
+//----------------------------------------------------------------------
+// FIFOPolicy::Enqueue
+// 	Put "thread" at the end of the ready list.
+//----------------------------------------------------------------------
+
+void
+FIFOPolicy::Enqueue(Thread* thread, bool wokeUp)
+{
+    readyList.Append(thread);
+}
+
+//----------------------------------------------------------------------
+// FIFOPolicy::Dequeue
+// 	Take the first thread off the ready list, or NULL if it's empty.
+//----------------------------------------------------------------------
+
+Thread *
+FIFOPolicy::Dequeue()
+{
+    return readyList.Remove();
+}
+
+//----------------------------------------------------------------------
+// ThreadPrint
+// 	Print one ready thread.  For debugging.
+//----------------------------------------------------------------------
+
+static void
+ThreadPrint (Thread* t) {
+  t->Print();
+}
+
+//----------------------------------------------------------------------
+// FIFOPolicy::Print
+// 	Print the contents of the ready list.
+//----------------------------------------------------------------------
+
+void
+FIFOPolicy::Print()
+{
+    readyList.Apply(ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::MLFQPolicy
+// 	Initialize one empty ready list per level.
+//----------------------------------------------------------------------
+
+MLFQPolicy::MLFQPolicy()
+{
+    for (int level = 0; level < NumSchedLevels; level++)
+	numReady[level] = 0;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Enqueue
+// 	Put "thread" at the end of the list of its level.
+//
+//	A thread that used up the quantum of its level drops one level.
+//	A thread that was blocked is boosted one level, up to its
+//	priority, and starts a fresh quantum: it gave up the CPU on its
+//	own, so it is most likely waiting on I/O or on the user.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Enqueue(Thread* thread, bool wokeUp)
+{
+    if (wokeUp) {
+	if (thread->schedLevel > thread->getPriority())
+	    thread->schedLevel--;
+	thread->schedUsed = 0;
+    } else if (thread->schedUsed >= Quantum(thread->schedLevel)) {
+	if (thread->schedLevel < NumSchedLevels - 1)
+	    thread->schedLevel++;
+	thread->schedUsed = 0;
+	DEBUG('t', "Thread \"%s\" used its quantum, now at level %d\n",
+	      thread->getName(), thread->schedLevel);
+    }
+    thread->readySince = stats->totalTicks;
+    levels[thread->schedLevel].Append(thread);
+    numReady[thread->schedLevel]++;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Age
+// 	Move up one level every thread at the front of a ready list that
+//	has waited more than SchedAgingTicks, so CPU bound threads that
+//	sank to the bottom levels aren't starved.  Lists are FIFO, so only
+//	their fronts need to be looked at.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Age()
+{
+    for (int level = 1; level < NumSchedLevels; level++) {
+	int aged = 0;
+	while (numReady[level] > aged) {
+	    Thread* thread = levels[level].Remove();
+	    if (stats->totalTicks - thread->readySince < SchedAgingTicks) {
+		levels[level].Prepend(thread);
+		break;
+	    }
+	    numReady[level]--;
+	    if (thread->getPriority() < level) {
+		DEBUG('t', "Aging thread \"%s\" to level %d\n",
+		      thread->getName(), level - 1);
+		thread->schedLevel = level - 1;
+		thread->schedUsed = 0;
+		levels[level - 1].Append(thread);
+		numReady[level - 1]++;
+	    } else {		// already at its priority, wait again
+		levels[level].Append(thread);
+		numReady[level]++;
+		aged++;
+	    }
+	    thread->readySince = stats->totalTicks;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Dequeue
+// 	Return the first thread of the most urgent non empty level, or
+//	NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+Thread *
+MLFQPolicy::Dequeue()
+{
+    Age();
+    for (int level = 0; level < NumSchedLevels; level++) {
+	if (numReady[level] > 0) {
+	    numReady[level]--;
+	    return levels[level].Remove();
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::IsEmpty
+// 	Return true if no level has a ready thread.
+//----------------------------------------------------------------------
+
+bool
+MLFQPolicy::IsEmpty()
+{
+    for (int level = 0; level < NumSchedLevels; level++)
+	if (numReady[level] > 0)
+	    return false;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Charge
+// 	"thread" ran for "ticks" more of its quantum.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Charge(Thread* thread, int ticks)
+{
+    thread->schedUsed += ticks;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::ShouldPreempt
+// 	The running thread is preempted when its quantum is over, or as
+//	soon as a thread of a more urgent level is ready.
+//----------------------------------------------------------------------
+
+bool
+MLFQPolicy::ShouldPreempt(Thread* running)
+{
+    if (running->schedUsed >= Quantum(running->schedLevel))
+	return true;
+    for (int level = 0; level < running->schedLevel; level++)
+	if (numReady[level] > 0)
+	    return true;
+    return false;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Print
+// 	Print the contents of every ready list.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Print()
+{
+    for (int level = 0; level < NumSchedLevels; level++) {
+	printf("\n  level %d: ", level);
+	levels[level].Apply(ThreadPrint);
+    }
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
-// 	Initialize the list of ready but not running threads to empty.
+// 	Initialize the ready threads to none.
+//
+//	"schedPolicy" decides in which order the ready threads run; the
+//	scheduler owns it from now on.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(SchedulingPolicy* schedPolicy)
 { 
-    readyList = new List<Thread*>; 
+    policy = schedPolicy;
+    dispatchTime = 0;
+    numSwitches = numSpaceSwitches = numTimed = 0;
+    switchStart = switchTime = 0;
 } 
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the ready threads' policy.
 //----------------------------------------------------------------------
 
 Scheduler::~Scheduler()
 { 
-    delete readyList; 
+    delete policy; 
 } 
 
+//----------------------------------------------------------------------
+// Scheduler::ChargeRunning
+// 	Charge the running thread for the ticks since it was dispatched,
+//	or since it was last charged.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ChargeRunning()
+{
+    policy->Charge(currentThread, stats->totalTicks - dispatchTime);
+    dispatchTime = stats->totalTicks;
+    accounting->ChargeRunning(currentThread);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::ReadyToRun
 // 	Mark a thread as ready, but not running.
-//	Put it on the ready list, for later scheduling onto the CPU.
+//	Hand it to the policy, for later scheduling onto the CPU.
+//	If the timer was stopped because nobody else wanted the CPU,
+//	restart it: now there is someone to preempt for.
 //
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
@@ -55,8 +273,15 @@ Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
+    bool wokeUp = thread->getStatus() == BLOCKED;
+    if (wokeUp)
+	accounting->Woken(thread, stats->totalTicks - thread->blockedSince);
+    if (thread == currentThread)	// yielding, charge it before it
+	ChargeRunning();		// is queued
     thread->setStatus(READY);
-    readyList->Append(thread);
+    policy->Enqueue(thread, wokeUp);
+    if (timer != NULL)
+	timer->Start();
 }
 
 //----------------------------------------------------------------------
@@ -70,7 +295,20 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-    return readyList->Remove();
+    return policy->Dequeue();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldPreempt
+// 	Called on each timer interrupt: charge the running thread and
+//	ask the policy whether it should yield.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldPreempt()
+{
+    ChargeRunning();
+    return policy->ShouldPreempt(currentThread);
 }
 
 //----------------------------------------------------------------------
@@ -93,20 +331,32 @@ Scheduler::Run (Thread *nextThread)
     Thread *oldThread = currentThread;
     
 #ifdef USER_PROGRAM			// ignore until running user programs 
-    if (currentThread->space != NULL) {	// if this thread is a user program,
+    if (currentThread->space != NULL)	// if this thread is a user program,
         currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveState();
-    }
+    // The address space is left loaded; the next one to be restored
+    // saves it, so switching through kernel threads costs nothing.
+
+    // Load the registers before SWITCH: a thread that runs for the
+    // first time starts in ThreadRoot, not after SWITCH below.
+    nextThread->RestoreUserState();
 #endif
     
+    if (oldThread->getStatus() != READY)	// blocked or finishing; a
+	ChargeRunning();			// yield was charged already
+    accounting->Switched(oldThread);
+
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
+    dispatchTime = stats->totalTicks;
+    accounting->Dispatched();
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
+    numSwitches++;
+    switchStart = HostNanoTime();
     
     // This is a machine-dependent assembly language routine defined 
     // in switch.s.  You may have to think
@@ -128,10 +378,32 @@ Scheduler::Run (Thread *nextThread)
     
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
-        currentThread->RestoreUserState();     // to restore, do it.
+	if (currentThread->space != TLBOwner)	// to restore, do it.
+	    numSpaceSwitches++;
 	currentThread->space->RestoreState();
     }
 #endif
+
+    // Threads that start in ThreadRoot don't get here, so only
+    // switches back into a thread are timed
+    numTimed++;
+    switchTime += HostNanoTime() - switchStart;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintStats
+// 	Print how many context switches there were, and how long they
+//	took on the host, on average.  Switching into a thread is timed
+//	from the moment the previous thread starts giving up the CPU, to
+//	the moment the thread is ready to go on.
+//----------------------------------------------------------------------
+
+void
+Scheduler::PrintStats()
+{
+    printf("Context switches: %d, %d between address spaces, %lld ns each\n",
+	numSwitches, numSpaceSwitches,
+	(numTimed > 0) ? switchTime / numTimed : 0);
 }
 
 //----------------------------------------------------------------------
@@ -140,14 +412,9 @@ Scheduler::Run (Thread *nextThread)
 //	the ready list.  For debugging.
 //----------------------------------------------------------------------
 
-static void
-ThreadPrint (Thread* t) {
-  t->Print();
-}
-
 void
 Scheduler::Print()
 {
     printf("Ready list contents:\n");
-    readyList->Apply(ThreadPrint);
+    policy->Print();
 }
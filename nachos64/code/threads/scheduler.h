@@ -2,6 +2,20 @@
 //	Data structures for the thread dispatcher and scheduler.
 //	Primarily, the list of threads that are ready to run.
 //
+//	The order in which ready threads run is decided by a scheduling
+//	policy.  Two policies are provided:
+//
+//		FIFO -- the original Nachos ready list, first come first
+//			served, every timer interrupt forces a switch
+//		MLFQ -- a multi-level feedback queue.  A thread that uses up
+//			its quantum drops one level (and gets a longer
+//			quantum); a thread that blocks is boosted one level
+//			when it wakes up; a thread that waits too long on
+//			the ready list is aged up one level.  A thread never
+//			runs above its priority, set with SetPriority.
+//
+//	MLFQ is the default; "-sp fifo" selects the original behavior.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -10,8 +24,82 @@
 #define SCHEDULER_H
 
 #include "copyright.h"
-#include "list.h"
 #include "thread.h"
+#include "threadqueue.h"
+
+// MLFQ levels; level 0 is the most urgent.  A thread's priority is the
+// highest level it may run at, so priority 0 is also the most urgent.
+const int NumSchedLevels = 4;
+const int MaxPriority = NumSchedLevels - 1;
+
+// Quantum of level 0, in ticks; each level below doubles it
+const int SchedQuantum = 2 * 100;
+
+// Ticks a thread may wait on the ready list before it is aged up
+const int SchedAgingTicks = 50 * SchedQuantum;
+
+// The following class defines the interface of a scheduling policy.
+// The policy only orders the ready threads; Scheduler does the rest.
+
+class SchedulingPolicy {
+  public:
+    virtual ~SchedulingPolicy() {}
+
+    virtual void Enqueue(Thread* thread, bool wokeUp) = 0;
+					// "thread" is ready; "wokeUp" if it
+					// was blocked until now
+    virtual Thread* Dequeue() = 0;	// Next thread to run, or NULL
+    virtual void Charge(Thread* thread, int ticks) = 0;
+					// "thread" ran for "ticks"
+    virtual bool ShouldPreempt(Thread* running) = 0;
+					// On a timer interrupt, should
+					// "running" give up the CPU?
+    virtual bool IsEmpty() = 0;		// No thread is ready?
+    virtual void Print() = 0;		// Print the ready threads
+};
+
+// Original Nachos policy: one FIFO ready list.
+
+class FIFOPolicy : public SchedulingPolicy {
+  public:
+    FIFOPolicy() {}
+    ~FIFOPolicy() {}
+
+    void Enqueue(Thread* thread, bool wokeUp);
+    Thread* Dequeue();
+    void Charge(Thread* thread, int ticks) {}
+    bool ShouldPreempt(Thread* running) { return true; }
+    bool IsEmpty() { return readyList.IsEmpty(); }
+    void Print();
+
+  private:
+    ThreadQueue readyList;  		// queue of threads that are ready to run,
+					// but not running
+};
+
+// Multi-level feedback queue: one FIFO ready list per level.
+
+class MLFQPolicy : public SchedulingPolicy {
+  public:
+    MLFQPolicy();
+    ~MLFQPolicy() {}
+
+    void Enqueue(Thread* thread, bool wokeUp);
+    Thread* Dequeue();
+    void Charge(Thread* thread, int ticks);
+    bool ShouldPreempt(Thread* running);
+    bool IsEmpty();
+    void Print();
+
+    static int Quantum(int level) { return SchedQuantum << level; }
+
+  private:
+    ThreadQueue levels[NumSchedLevels];	// ready threads, by level
+    int numReady[NumSchedLevels];	// threads on each list
+
+    void Age();				// move up threads that waited
+					// too long on the ready lists
+};
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
@@ -19,18 +107,33 @@
 
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
+    Scheduler(SchedulingPolicy* schedPolicy);	// Initialize the ready
+					// threads, ordered by "schedPolicy"
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
-    Thread* FindNextToRun();		// Dequeue first thread on the ready 
-					// list, if any, and return thread.
+    Thread* FindNextToRun();		// Dequeue the next thread the policy
+					// picks, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
+    bool ShouldPreempt();		// Has the running thread had its turn?
+    bool HasReady() { return !policy->IsEmpty(); }
+					// Is any thread waiting for the CPU?
     void Print();			// Print contents of ready list
+    void PrintStats();			// Print the cost of context switches
     
   private:
-    List<Thread*> *readyList;  		// queue of threads that are ready to run,
-					// but not running
+    SchedulingPolicy* policy;		// orders the ready threads
+    long long dispatchTime;		// when the running thread was last
+					// charged for its CPU time
+
+    int numSwitches;			// context switches
+    int numSpaceSwitches;		// of those, into another address space
+    int numTimed;			// switches whose cost was measured
+    long long switchStart;		// host time the last switch started
+    long long switchTime;		// host nanoseconds spent switching
+
+    void ChargeRunning();		// charge the running thread's CPU
+					// time to it
 };
 
 #endif // SCHEDULER_H
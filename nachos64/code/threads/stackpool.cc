@@ -0,0 +1,122 @@
+// stackpool.cc 
+//	Routines to allocate, recycle and release thread stacks.
+//
+//	A stack region looks like this, from low to high addresses:
+//
+//		guard page | stackBytes of stack | guard page
+//
+//	and the address handed out is the bottom of the usable part.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "stackpool.h"
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+//----------------------------------------------------------------------
+// StackPool::StackPool
+// 	Initialize an empty pool of stacks.
+//
+//	"stackWords" is the usable size of each stack, in words; it is
+//	rounded up to whole host pages.
+//----------------------------------------------------------------------
+
+StackPool::StackPool(int stackWords)
+{
+    ASSERT(stackWords > 0);
+    pageBytes = getpagesize();
+    stackBytes = stackWords * sizeof(HostMemoryAddress);
+    stackBytes = (stackBytes + pageBytes - 1) / pageBytes * pageBytes;
+    numWords = stackBytes / sizeof(HostMemoryAddress);
+
+    freeList = NULL;
+    numFree = 0;
+    numMapped = numReused = 0;
+}
+
+//----------------------------------------------------------------------
+// StackPool::~StackPool
+// 	Unmap the stacks on the free list.  Stacks still in use by some
+//	thread are left alone.
+//----------------------------------------------------------------------
+
+StackPool::~StackPool()
+{
+    while (freeList != NULL) {
+	HostMemoryAddress* stack = freeList;
+	freeList = (HostMemoryAddress*) *stack;
+	munmap((char*) stack - pageBytes, stackBytes + 2 * pageBytes);
+    }
+}
+
+//----------------------------------------------------------------------
+// StackPool::Allocate
+// 	Return the bottom of an unused stack: one from the free list if
+//	there is any, a freshly mapped one otherwise.
+//----------------------------------------------------------------------
+
+HostMemoryAddress*
+StackPool::Allocate()
+{
+    HostMemoryAddress* stack;
+
+    if (freeList != NULL) {
+	stack = freeList;
+	freeList = (HostMemoryAddress*) *stack;
+	numFree--;
+	numReused++;
+	return stack;
+    }
+
+    char* region = (char*) mmap(NULL, stackBytes + 2 * pageBytes,
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+				-1, 0);
+    ASSERT(region != (char*) MAP_FAILED);
+    mprotect(region, pageBytes, PROT_NONE);
+    mprotect(region + pageBytes + stackBytes, pageBytes, PROT_NONE);
+    numMapped++;
+    DEBUG('t', "Mapped stack %d at 0x%lx\n", numMapped,
+	  (unsigned long) (region + pageBytes));
+    return (HostMemoryAddress*) (region + pageBytes);
+}
+
+//----------------------------------------------------------------------
+// StackPool::Free
+// 	Give back a stack that no thread runs on any more.  It is kept
+//	for the next Allocate, unless the free list is already full.
+//
+//	"stack" is the bottom of the stack, as returned by Allocate.
+//----------------------------------------------------------------------
+
+void
+StackPool::Free(HostMemoryAddress* stack)
+{
+    if (numFree >= StackPoolMaxFree) {
+	munmap((char*) stack - pageBytes, stackBytes + 2 * pageBytes);
+	return;
+    }
+    *stack = (HostMemoryAddress) freeList;
+    freeList = stack;
+    numFree++;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Print
+// 	Print how many stacks were mapped and how many were recycled.
+//----------------------------------------------------------------------
+
+void
+StackPool::Print()
+{
+    printf("Stacks: %d words each, %d mapped, %d reused, %d free\n",
+	numWords, numMapped, numReused, numFree);
+}
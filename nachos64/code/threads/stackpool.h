@@ -0,0 +1,56 @@
+// stackpool.h 
+//	Data structures to hand out thread execution stacks.
+//
+//	Each stack is its own mmap'd region, with a PROT_NONE guard page
+//	below it (stacks grow down) and another above it, so that running
+//	off either end of a stack faults right away, instead of silently
+//	corrupting whatever was allocated next to it.  The region is mapped
+//	without reserving swap, so the host only commits the pages of a
+//	stack that are actually touched.
+//
+//	Stacks of finished threads are kept on a free list and handed to
+//	the next Fork, so creating threads doesn't go back to the host
+//	every time.  At most StackPoolMaxFree stacks are kept; beyond
+//	that they are unmapped.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef STACKPOOL_H
+#define STACKPOOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// Most free stacks kept mapped for reuse
+const int StackPoolMaxFree = 64;
+
+// The following class defines the pool of thread stacks.  All the
+// stacks have the same size, set when the pool is created.
+
+class StackPool {
+  public:
+    StackPool(int stackWords);		// Stacks of "stackWords" words
+    ~StackPool();			// Unmap the free stacks
+
+    HostMemoryAddress* Allocate();	// Return the bottom of a stack
+    void Free(HostMemoryAddress* stack);	// Give a stack back
+    int StackWords() { return numWords; }	// size of each stack
+
+    void Print();			// Print the pool statistics
+
+  private:
+    int numWords;			// usable words of each stack
+    int stackBytes;			// usable bytes, rounded to pages
+    int pageBytes;			// host page size
+
+    HostMemoryAddress* freeList;	// free stacks; the bottom word of
+					// each one points to the next
+    int numFree;
+
+    int numMapped;			// stacks mapped from the host
+    int numReused;			// stacks taken from the free list
+};
+
+#endif // STACKPOOL_H
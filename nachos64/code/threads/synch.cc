@@ -1,8 +1,8 @@
 // synch.cc 
-//	Routines for synchronizing threads.  Three kinds of
-//	synchronization routines are defined here: semaphores, locks 
-//   	and condition variables (the implementation of the last two
-//	are left to the reader).
+//	Routines for synchronizing threads.  Four kinds of
+//	synchronization routines are defined here: semaphores, locks,
+//   	condition variables and reader-writer locks (the implementation
+//	of the last three are left to the reader).
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -17,6 +17,10 @@
 // re-set the interrupt state back to its original value (whether
 // that be disabled or enabled).
 //
+// When profiling is on ("synchProfiler" is set), every primitive also
+// counts its acquisitions and the ticks threads spend blocked on it;
+// see synchprof.h.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -37,7 +41,8 @@ Semaphore::Semaphore(const char* debugName, int initialValue)
 {
     name = (char *)debugName;
     value = initialValue;
-    queue = new List<Thread*>;
+    profile = (synchProfiler != NULL) ?
+		synchProfiler->Register(SemaphoreSynch, debugName) : NULL;
 }
 
 //----------------------------------------------------------------------
@@ -48,7 +53,6 @@ Semaphore::Semaphore(const char* debugName, int initialValue)
 
 Semaphore::~Semaphore()
 {
-    delete queue;
 }
 
 //----------------------------------------------------------------------
@@ -65,13 +69,17 @@ void
 Semaphore::P()
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    long long start = stats->totalTicks;
+    bool blocked = (value == 0);
     
     while (value == 0) { 			// semaphore not available
-	queue->Append(currentThread);		// so go to sleep
+	queue.Append(currentThread);		// so go to sleep
 	currentThread->Sleep();
     } 
     value--; 					// semaphore available, 
 						// consume its value
+    if (profile != NULL)
+	profile->Acquired(blocked, stats->totalTicks - start);
     
     interrupt->SetLevel(oldLevel);		// re-enable interrupts
 }
@@ -90,7 +98,7 @@ Semaphore::V()
     Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    thread = queue->Remove();
+    thread = queue.Remove();
     if (thread != NULL)	   // make thread ready, consuming the V immediately
 	scheduler->ReadyToRun(thread);
     value++;
@@ -110,7 +118,7 @@ Semaphore::Destroy()
     Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    while ( (thread = queue->Remove() ) != NULL )	// make thread ready
+    while ( (thread = queue.Remove() ) != NULL )	// make thread ready
 	scheduler->ReadyToRun(thread);
 
     interrupt->SetLevel(oldLevel);
@@ -124,36 +132,57 @@ Semaphore::Destroy()
 // the test case in the network assignment won't work!
 Lock::Lock(const char* debugName) {
 
-    char tmp[50];
-
     name = (char *) debugName;
     lockHolder = NULL;			// No process holds this lock
-    sprintf( tmp, "%s mutex", name );
-    mutex = new Semaphore( tmp, 1 );
+    acquiredAt = 0;
+    profile = ( synchProfiler != NULL ) ?
+		synchProfiler->Register( LockSynch, debugName ) : NULL;
 
 }
 
 
 Lock::~Lock() {
 
-    delete mutex;
-
 }
 
 
+// Waits the same way as Semaphore::P, so the lock can tell how long
+// it was waited for and held.
 void Lock::Acquire() {
 
-    mutex->P();
+    IntStatus oldLevel = interrupt->SetLevel( IntOff );
+    long long start = stats->totalTicks;
+    bool blocked = ( lockHolder != NULL );
+
+    while ( lockHolder != NULL ) {	// Lock is BUSY
+        queue.Append( currentThread );
+        currentThread->Sleep();
+    }
     lockHolder = currentThread;
+    acquiredAt = stats->totalTicks;
+    if ( profile != NULL ) {
+        profile->Acquired( blocked, acquiredAt - start );
+    }
+    interrupt->SetLevel( oldLevel );
 
 }
 
 
 void Lock::Release() {
 
+    Thread * waiter;
+
     ASSERT( isHeldByCurrentThread() );
+    IntStatus oldLevel = interrupt->SetLevel( IntOff );
+    if ( profile != NULL ) {
+        profile->Held( stats->totalTicks - acquiredAt );
+    }
     lockHolder = NULL;
-    mutex->V();
+    waiter = queue.Remove();
+    if ( waiter != NULL ) {
+        scheduler->ReadyToRun( waiter );
+    }
+    interrupt->SetLevel( oldLevel );
 
 }
 
@@ -168,52 +197,143 @@ bool Lock::isHeldByCurrentThread() {
 Condition::Condition(const char* debugName) {
 
     name = (char *) debugName;
-    waitQueue = new List<Semaphore *>;
+    profile = ( synchProfiler != NULL ) ?
+		synchProfiler->Register( ConditionSynch, debugName ) : NULL;
 
 }
 
 
 Condition::~Condition() {
 
-    delete waitQueue;
-
 }
 
 
+// The waiter queues itself and releases the lock with interrupts off,
+// so a Signal can't slip in before it is asleep.
 void Condition::Wait( Lock * conditionLock ) {
 
-    Semaphore * waiter;
-
     ASSERT( conditionLock->isHeldByCurrentThread() );
 
-    waiter = new Semaphore("condition", 0);
-    waitQueue->Append( waiter );
+    IntStatus oldLevel = interrupt->SetLevel( IntOff );
+    long long start = stats->totalTicks;
+    waitQueue.Append( currentThread );
     conditionLock->Release();		// Release lock before sleeping
-    waiter->P();
+    currentThread->Sleep();
+    if ( profile != NULL ) {		// Always blocks; the time to get
+					// the lock back counts on the lock
+        profile->Acquired( true, stats->totalTicks - start );
+    }
+    interrupt->SetLevel( oldLevel );
     conditionLock->Acquire();		// Regains the lock
-    delete waiter;
 }
 
 
 void Condition::Signal( Lock * conditionLock ) {
 
-    Semaphore * waiter;
+    Thread * waiter;
 
     ASSERT( conditionLock->isHeldByCurrentThread() );
 
-    if ( ! waitQueue->IsEmpty() ) {
-        waiter = waitQueue->Remove();
-        waiter->V();
+    IntStatus oldLevel = interrupt->SetLevel( IntOff );
+    waiter = waitQueue.Remove();
+    if ( waiter != NULL ) {
+        scheduler->ReadyToRun( waiter );
     }
+    interrupt->SetLevel( oldLevel );
 
 }
 
 
 void Condition::Broadcast( Lock * conditionLock ) {
 
-    while ( ! waitQueue->IsEmpty() ) {
+    while ( ! waitQueue.IsEmpty() ) {
         Signal( conditionLock );
     }
 
 }
 
+
+RWLock::RWLock(const char* debugName) {
+
+    name = (char *) debugName;
+    mutex = new Lock( debugName );
+    readersOk = new Condition( debugName );
+    writersOk = new Condition( debugName );
+    readers = 0;
+    waitingWriters = 0;
+    writer = NULL;			// No thread holds this lock
+
+}
+
+
+RWLock::~RWLock() {
+
+    delete writersOk;
+    delete readersOk;
+    delete mutex;
+
+}
+
+
+void RWLock::AcquireRead() {
+
+    mutex->Acquire();
+    while ( writer != NULL || waitingWriters > 0 ) {
+        readersOk->Wait( mutex );
+    }
+    readers++;
+    mutex->Release();
+
+}
+
+
+// The last reader out lets a waiting writer in.
+void RWLock::ReleaseRead() {
+
+    mutex->Acquire();
+    ASSERT( readers > 0 );
+    readers--;
+    if ( readers == 0 ) {
+        writersOk->Signal( mutex );
+    }
+    mutex->Release();
+
+}
+
+
+void RWLock::AcquireWrite() {
+
+    mutex->Acquire();
+    waitingWriters++;
+    while ( writer != NULL || readers > 0 ) {
+        writersOk->Wait( mutex );
+    }
+    waitingWriters--;
+    writer = currentThread;
+    mutex->Release();
+
+}
+
+
+// Writers go first, if any are waiting; otherwise all the readers
+// held back by this writer are let in together.
+void RWLock::ReleaseWrite() {
+
+    mutex->Acquire();
+    ASSERT( isWriteHeldByCurrentThread() );
+    writer = NULL;
+    if ( waitingWriters > 0 ) {
+        writersOk->Signal( mutex );
+    } else {
+        readersOk->Broadcast( mutex );
+    }
+    mutex->Release();
+
+}
+
+
+bool RWLock::isWriteHeldByCurrentThread() {
+
+   return (writer == currentThread);
+
+}
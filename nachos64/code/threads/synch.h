@@ -1,11 +1,11 @@
 // synch.h
 //	Data structures for synchronizing threads.
 //
-//	Three kinds of synchronization are defined here: semaphores,
-//	locks, and condition variables.  The implementation for
-//	semaphores is given; for the latter two, only the procedure
-//	interface is given -- they are to be implemented as part of
-//	the first assignment.
+//	Four kinds of synchronization are defined here: semaphores,
+//	locks, condition variables, and reader-writer locks.  The
+//	implementation for semaphores is given; for the latter ones, only
+//	the procedure interface is given -- they are to be implemented as
+//	part of the first assignment.
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -19,7 +19,8 @@
 
 #include "copyright.h"
 #include "thread.h"
-#include "list.h"
+#include "threadqueue.h"
+#include "synchprof.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -50,7 +51,8 @@ class Semaphore {
   private:
     char* name;			// useful for debugging
     int value;			// semaphore value, always >= 0
-    List<Thread*> *queue;	// threads waiting in P() for the value to be > 0
+    ThreadQueue queue;		// threads waiting in P() for the value to be > 0
+    SynchRecord* profile;	// contention counters, NULL if not profiling
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -83,7 +85,10 @@ class Lock {
     char* name;				// for debugging
     // plus some other stuff you'll need to define
     Thread * lockHolder;
-    Semaphore * mutex;
+    ThreadQueue queue;			// threads waiting in Acquire()
+    long long acquiredAt;		// when lockHolder got the lock
+    SynchRecord * profile;		// contention counters, NULL if
+					// not profiling
 };
 
 // The following class defines a "condition variable".  A condition
@@ -136,6 +141,45 @@ class Condition {
   private:
     char* name;
     // plus some other stuff you'll need to define
-    List<Semaphore *> *waitQueue;
+    ThreadQueue waitQueue;		// threads waiting to be signalled
+    SynchRecord* profile;		// contention counters, NULL if
+					// not profiling
+};
+
+// The following class defines a "reader-writer lock".  Any number of
+// readers may hold the lock at once, or a single writer:
+//
+//	AcquireRead -- wait until no writer holds or waits for the lock,
+//		then become one more reader
+//
+//	AcquireWrite -- wait until there are no readers and no writer,
+//		then hold the lock alone
+//
+// Waiting writers keep new readers out, so a steady stream of readers
+// can't starve a writer.  For the same reason, a thread must not
+// acquire a reader-writer lock it already holds, even for reading.
+
+class RWLock {
+  public:
+    RWLock(const char* debugName);	// initialize lock to be FREE
+    ~RWLock();				// deallocate lock
+    char* getName() { return name; }	// debugging assist
+
+    void AcquireRead();			// shared access
+    void ReleaseRead();
+    void AcquireWrite();		// exclusive access
+    void ReleaseWrite();
+
+    bool isWriteHeldByCurrentThread();	// true if the current thread
+					// holds this lock for writing
+
+  private:
+    char* name;				// for debugging
+    Lock* mutex;			// protects the fields below
+    Condition* readersOk;		// no writer holds or waits
+    Condition* writersOk;		// nobody holds the lock
+    int readers;			// threads holding it for reading
+    int waitingWriters;			// threads waiting in AcquireWrite
+    Thread* writer;			// thread holding it for writing
 };
 #endif // SYNCH_H
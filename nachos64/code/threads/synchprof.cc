@@ -0,0 +1,223 @@
+// synchprof.cc 
+//	Routines to keep and report synchronization contention counters.
+//
+//	Records are kept for the whole run, even after every primitive
+//	that used them is gone, so the report covers short-lived
+//	primitives too.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchprof.h"
+#include "system.h"
+
+static const char *synchKindNames[] = { "semaphore", "lock", "condition" };
+
+//----------------------------------------------------------------------
+// SynchRecord::SynchRecord
+// 	Initialize the counters for primitives of kind "synchKind",
+//	called "synchName".
+//----------------------------------------------------------------------
+
+SynchRecord::SynchRecord(SynchKind synchKind, const char *synchName)
+{
+    kind = synchKind;
+    name = new char[strlen(synchName) + 1];
+    strcpy(name, synchName);
+    acquires = contended = 0;
+    waitTicks = holdTicks = 0;
+    maxWait = maxHold = 0;
+    numWaiters = 0;
+    next = NULL;
+}
+
+SynchRecord::~SynchRecord()
+{
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// SynchRecord::Acquired
+// 	Count an acquisition by the current thread.  If it had to block,
+//	for "waited" ticks, charge the wait to the thread as well.  When
+//	the table of waiters is full, the one that waited least makes
+//	room, so the longest waiters are kept.
+//----------------------------------------------------------------------
+
+void
+SynchRecord::Acquired(bool blocked, int waited)
+{
+    int i, least = 0;
+    const char *thread;
+
+    acquires++;
+    if (!blocked)
+	return;
+    contended++;
+    waitTicks += waited;
+    if (waited > maxWait)
+	maxWait = waited;
+
+    thread = currentThread->getName();
+    for (i = 0; i < numWaiters; i++) {
+	if (!strncmp(waiters[i].name, thread, SynchNameSize - 1))
+	    break;
+	if (waiters[i].ticks < waiters[least].ticks)
+	    least = i;
+    }
+    if (i == numWaiters) {			// a new waiter
+	if (numWaiters < SynchMaxWaiters)
+	    numWaiters++;
+	else
+	    i = least;
+	strncpy(waiters[i].name, thread, SynchNameSize - 1);
+	waiters[i].name[SynchNameSize - 1] = '\0';
+	waiters[i].count = 0;
+	waiters[i].ticks = 0;
+    }
+    waiters[i].count++;
+    waiters[i].ticks += waited;
+}
+
+//----------------------------------------------------------------------
+// SynchRecord::Held
+// 	Count "ticks" of a lock being held.
+//----------------------------------------------------------------------
+
+void
+SynchRecord::Held(int ticks)
+{
+    holdTicks += ticks;
+    if (ticks > maxHold)
+	maxHold = ticks;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::SynchProfiler
+// 	Initialize a profiler with no records.
+//----------------------------------------------------------------------
+
+SynchProfiler::SynchProfiler()
+{
+    for (int i = 0; i < SynchProfileBuckets; i++)
+	buckets[i] = NULL;
+    numRecords = 0;
+}
+
+SynchProfiler::~SynchProfiler()
+{
+    for (int i = 0; i < SynchProfileBuckets; i++) {
+	while (buckets[i] != NULL) {
+	    SynchRecord *record = buckets[i];
+	    buckets[i] = record->next;
+	    delete record;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Register
+// 	Return the record for primitives of kind "kind" called "name",
+//	making it if this is the first one.  Called when a primitive is
+//	created, so only then do we pay for the lookup.
+//----------------------------------------------------------------------
+
+SynchRecord*
+SynchProfiler::Register(SynchKind kind, const char *name)
+{
+    unsigned int hash = kind;
+    SynchRecord *record;
+
+    if (name == NULL)
+	name = "(unnamed)";
+    for (const char *c = name; *c != '\0'; c++)
+	hash = hash * 31 + (unsigned char) *c;
+    hash %= SynchProfileBuckets;
+
+    for (record = buckets[hash]; record != NULL; record = record->next)
+	if (record->kind == kind && !strcmp(record->name, name))
+	    return record;
+
+    record = new SynchRecord(kind, name);
+    record->next = buckets[hash];
+    buckets[hash] = record;
+    numRecords++;
+    return record;
+}
+
+//----------------------------------------------------------------------
+// CompareRecords, CompareWaiters
+// 	Order records and waiters for the report: most ticks blocked
+//	first, then most blocked acquisitions.
+//----------------------------------------------------------------------
+
+static int
+CompareRecords(const void *a, const void *b)
+{
+    const SynchRecord *x = *(const SynchRecord **) a;
+    const SynchRecord *y = *(const SynchRecord **) b;
+
+    if (x->waitTicks != y->waitTicks)
+	return (x->waitTicks > y->waitTicks) ? -1 : 1;
+    if (x->contended != y->contended)
+	return y->contended - x->contended;
+    return y->acquires - x->acquires;
+}
+
+static int
+CompareWaiters(const void *a, const void *b)
+{
+    const SynchWaiter *x = (const SynchWaiter *) a;
+    const SynchWaiter *y = (const SynchWaiter *) b;
+
+    if (x->ticks != y->ticks)
+	return (x->ticks > y->ticks) ? -1 : 1;
+    return y->count - x->count;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Print
+// 	Print every record that was used, the most contended first,
+//	with its top waiters.
+//----------------------------------------------------------------------
+
+void
+SynchProfiler::Print()
+{
+    SynchRecord **sorted = new SynchRecord*[numRecords];
+    int numUsed = 0;
+
+    for (int i = 0; i < SynchProfileBuckets; i++)
+	for (SynchRecord *record = buckets[i]; record != NULL;
+	     record = record->next)
+	    if (record->acquires > 0)
+		sorted[numUsed++] = record;
+    qsort(sorted, numUsed, sizeof(SynchRecord *), CompareRecords);
+
+    printf("Synch profile: %d of %d primitive names used, by ticks blocked\n",
+	numUsed, numRecords);
+    for (int i = 0; i < numUsed; i++) {
+	SynchRecord *record = sorted[i];
+
+	printf("  %s \"%s\": acquires %d, contended %d, "
+	    "blocked %lld (max %d)", synchKindNames[record->kind],
+	    record->name, record->acquires, record->contended,
+	    record->waitTicks, record->maxWait);
+	if (record->kind == LockSynch)
+	    printf(", held %lld (max %d)", record->holdTicks, record->maxHold);
+	printf("\n");
+
+	if (record->numWaiters > 0) {
+	    qsort(record->waiters, record->numWaiters, sizeof(SynchWaiter),
+		  CompareWaiters);
+	    printf("    top waiters:");
+	    for (int j = 0; j < record->numWaiters && j < SynchTopWaiters; j++)
+		printf(" \"%s\" %lld/%d", record->waiters[j].name,
+		    record->waiters[j].ticks, record->waiters[j].count);
+	    printf("\n");
+	}
+    }
+    delete [] sorted;
+}
@@ -0,0 +1,88 @@
+// synchprof.h 
+//	Data structures to profile contention on semaphores, locks and
+//	condition variables.
+//
+//	Primitives are grouped by kind and name: all the locks called
+//	"file header", for instance, share one record.  For each one we
+//	count acquisitions (P, Acquire or Wait), how many of them had to
+//	block, and the simulated ticks spent blocked; for locks, also the
+//	ticks the lock was held.  A few of the threads that waited longest
+//	are kept by name.
+//
+//	A primitive finds its record once, when it is created, and then
+//	only bumps counters, so profiling can be left on for benchmarks.
+//	The report, sorted by time spent blocked, is printed at halt.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHPROF_H
+#define SYNCHPROF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+enum SynchKind { SemaphoreSynch, LockSynch, ConditionSynch };
+
+const int SynchMaxWaiters = 8;		// waiting threads kept per record
+const int SynchTopWaiters = 3;		// of which printed in the report
+const int SynchNameSize = 24;		// longest thread name kept
+const int SynchProfileBuckets = 64;	// hash table size
+
+// The following class defines one waiting thread, in a record.
+
+class SynchWaiter {
+  public:
+    char name[SynchNameSize];		// the thread
+    int count;				// times it blocked
+    long long ticks;			// ticks it spent blocked
+};
+
+// The following class defines the counters shared by every primitive
+// of the same kind and name.
+
+class SynchRecord {
+  public:
+    SynchRecord(SynchKind synchKind, const char *synchName);
+    ~SynchRecord();
+
+    void Acquired(bool blocked, int waited);	// one more acquisition,
+					// which blocked for "waited" ticks
+					// if "blocked"
+    void Held(int ticks);		// a lock was held for "ticks"
+
+    SynchKind kind;
+    char *name;				// copied, primitives' names may not
+					// outlive them
+    int acquires;			// acquisitions
+    int contended;			// acquisitions that had to block
+    long long waitTicks;		// ticks spent blocked
+    int maxWait;			// longest single wait
+    long long holdTicks;		// ticks held, for locks
+    int maxHold;			// longest single hold
+
+    SynchWaiter waiters[SynchMaxWaiters];	// who blocked the longest
+    int numWaiters;
+
+    SynchRecord *next;			// next in the same hash bucket
+};
+
+// The following class defines the profiler, which owns the records.
+
+class SynchProfiler {
+  public:
+    SynchProfiler();
+    ~SynchProfiler();
+
+    SynchRecord* Register(SynchKind kind, const char *name);
+					// The record for primitives of this
+					// kind and name; made if needed
+    void Print();			// Print the report
+
+  private:
+    SynchRecord *buckets[SynchProfileBuckets];	// records, by name
+    int numRecords;
+};
+
+#endif // SYNCHPROF_H
@@ -19,10 +19,17 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+HostIO *hostIO;				// waits for console and network
+					// input on the host
+StackPool *stackPool;			// thread execution stacks
+Alarm *alarmClock;			// threads sleeping until some time
+SynchProfiler *synchProfiler;		// NULL unless "-lp" was given
+Accounting *accounting;			// usage of each thread and
+					// address space
 
 // 2007, Jose Miguel Santos Espino
 PreemptiveScheduler* preemptiveScheduler = NULL;
-const long long DEFAULT_TIME_SLICE = 50000;
+const long long DEFAULT_TIME_SLICE = 1000;	// microseconds
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -37,11 +44,26 @@ Machine *machine;
 BitMap* MemBitMap;	// user program memory and registers
 BitMap* SWAPBitMap;
 TranslationEntry* IPT[NumPhysPages];
+AddrSpace* IPTOwner[NumPhysPages];
+AddrSpace* TLBOwner;
 int indexTLBFIFO;
 int indexSWAPFIFO;
 bool threadFirstTime;
 int indexTLBSndChc;
 int indexSWAPSndChc;
+ExecCache *execCache;		// images of the programs launched
+ProcessTable *processTable;	// user processes, by SpaceId
+AsyncIOTable *asyncRequests;	// ReadAsync and WriteAsync requests
+FutexTable *futexes;		// threads sleeping on user semaphores
+ConsoleBuffer *consoleBuffer;	// user console input and output
+#endif
+
+#ifdef VM
+SwapCache *swapCache;		// NULL unless "-cs" was given
+FaultStats *faultStats;		// NULL unless "-fr" was given
+SharedMemory *sharedMemory;
+SharedSegment *IPTSegment[NumPhysPages];	// NULL unless the frame
+						// holds a shared page
 #endif
 
 #ifdef NETWORK
@@ -52,8 +74,15 @@ PostOffice *postOffice;
 // External definition, to allow us to take a pointer to this function
 extern void Cleanup();
 
+#ifdef USER_PROGRAM
+extern void PrintSyscallStats();	// in exception.cc
+#endif
+
+
 
 
+static bool ticklessTimer = true;	// stop the timer when nobody
+					// is ready to run
 
 //----------------------------------------------------------------------
 // TimerInterruptHandler
@@ -62,6 +91,11 @@ extern void Cleanup();
 //	This routine is called each timeALRM there is a timer interrupt,
 //	with interrupts disabled.
 //
+//	Unless the timer is periodic (-pt), it is stopped as soon as no
+//	thread is ready: there is nobody to preempt the running thread
+//	for, and while idle, Interrupt::Idle can skip straight to the next
+//	alarm or device interrupt.  Scheduler::ReadyToRun starts it again.
+//
 //	Note that instead of calling Yield() directly (which would
 //	suspend the interrupt handler, not the interrupted thread
 //	which is what we wanted to context switch), we set a flag
@@ -75,10 +109,25 @@ extern void Cleanup();
 static void
 TimerInterruptHandler(void* dummy)
 {
-    if (interrupt->getStatus() != IdleMode)
+    if (ticklessTimer && !scheduler->HasReady()) {
+	timer->Stop();
+	return;
+    }
+    if (interrupt->getStatus() != IdleMode && scheduler->ShouldPreempt())
 	interrupt->YieldOnReturn();
 }
 
+//----------------------------------------------------------------------
+// SnapshotHandler
+// 	Called on SIGUSR1.  Ask for an accounting snapshot; it is printed
+//	on the next tick, when the simulation is in a consistent state.
+//----------------------------------------------------------------------
+static void
+SnapshotHandler()
+{
+    accounting->RequestSnapshot();
+}
+
 //----------------------------------------------------------------------
 // Initialize
 // 	Initialize Nachos global data structures.  Interpret command
@@ -92,6 +141,7 @@ TimerInterruptHandler(void* dummy)
 void
 Initialize(int argc, char **argv)
 {
+#ifdef USER_PROGRAM
     MemBitMap =  new BitMap( NumPhysPages );
 		SWAPBitMap =  new BitMap( SWAPSize );
 		indexTLBFIFO = 0;
@@ -102,10 +152,19 @@ Initialize(int argc, char **argv)
     for (int index = 0; index < NumPhysPages; ++index)
     {
       IPT[index] = NULL;
+      IPTOwner[index] = NULL;
+#ifdef VM
+      IPTSegment[index] = NULL;
+#endif
     }
+#endif
     int argCount;
     const char* debugArgs = "";
     bool randomYield = false;
+    bool fifoScheduling = false;	// original FIFO ready list
+    int stackWords = StackSize;		// size of each thread stack
+    bool synchProfile = false;		// profile synchronization
+    const char* accountReport = NULL;	// accounting report file
 
 
 // 2007, Jose Miguel Santos Espino
@@ -114,6 +173,11 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;	// single step user program
+    int execCachePages = ExecCacheDefaultPages;	// program pages to keep
+#endif
+#ifdef VM
+    int swapCacheSize = 0;	// bytes of compressed swap, 0 to disable
+    const char* faultReport = NULL;	// page fault report file
 #endif
 #ifdef FILESYS_NEEDED
     bool format = false;	// format disk
@@ -138,11 +202,33 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = true;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-sp")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "fifo"))
+		fifoScheduling = true;
+	    else
+		ASSERT(!strcmp(*(argv + 1), "mlfq"));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-pt")) {
+	    ticklessTimer = false;
+	} else if (!strcmp(*argv, "-ss")) {
+	    ASSERT(argc > 1);
+	    stackWords = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-lp"))
+	    synchProfile = true;
+	else if (!strcmp(*argv, "-ac")) {
+	    if (argc == 1 || (*(argv + 1))[0] == '-') {
+	        accountReport = "accounting.json";
+	    } else {
+	        accountReport = *(argv + 1);
+	        argCount = 2;
+	    }
 	}
 	// 2007, Jose Miguel Santos Espino
 	else if (!strcmp(*argv, "-p")) {
 	    preemptiveScheduling = true;
-	    if (argc == 1) {
+	    if (argc == 1 || (*(argv + 1))[0] == '-') {
 	        timeSlice = DEFAULT_TIME_SLICE;
 	    } else {
 	        timeSlice = atoi(*(argv+1));
@@ -152,6 +238,28 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = true;
+	else if (!strcmp(*argv, "-ec")) {
+	    ASSERT(argc > 1);
+	    execCachePages = atoi(*(argv + 1));
+	    argCount = 2;
+	}
+#endif
+#ifdef VM
+	if (!strcmp(*argv, "-cs")) {
+	    if (argc == 1 || (*(argv + 1))[0] == '-') {
+	        swapCacheSize = SwapCacheDefaultSize;
+	    } else {
+	        swapCacheSize = atoi(*(argv + 1));
+	        argCount = 2;
+	    }
+	} else if (!strcmp(*argv, "-fr")) {
+	    if (argc == 1 || (*(argv + 1))[0] == '-') {
+	        faultReport = "faults.json";
+	    } else {
+	        faultReport = *(argv + 1);
+	        argCount = 2;
+	    }
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -171,10 +279,20 @@ Initialize(int argc, char **argv)
     }
 
     DebugInit(debugArgs);			// initialize DEBUG messages
+    if (synchProfile)				// before any primitive is made
+	synchProfiler = new SynchProfiler();
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
-    if (randomYield)				// start the timer (if needed)
+    hostIO = new HostIO();			// before any device
+    stackPool = new StackPool(stackWords);	// no stacks mapped yet
+    alarmClock = new Alarm();			// nobody sleeping yet
+    accounting = new Accounting(accountReport);	// before any thread
+    if (fifoScheduling)				// initialize the ready queue
+	scheduler = new Scheduler(new FIFOPolicy());
+    else
+	scheduler = new Scheduler(new MLFQPolicy());
+    if (randomYield || !fifoScheduling)	// start the timer (if needed);
+						// MLFQ needs it for quanta
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
     threadToBeDestroyed = NULL;
@@ -187,6 +305,7 @@ Initialize(int argc, char **argv)
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
+    CallOnUserSignal(SnapshotHandler);		// "kill -USR1" for a snapshot
 
     // Jose Miguel Santos Espino, 2007
     if ( preemptiveScheduling ) {
@@ -197,6 +316,23 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    currentThread->RestoreUserState();		// main's registers
+    TLBOwner = NULL;
+    execCache = new ExecCache(execCachePages);
+    processTable = new ProcessTable();
+    asyncRequests = new AsyncIOTable();
+    futexes = new FutexTable();
+    consoleBuffer = new ConsoleBuffer();
+#endif
+
+#ifdef VM
+    swapCache = NULL;
+    if (swapCacheSize > 0)
+	swapCache = new SwapCache(swapCacheSize);
+    faultStats = NULL;
+    if (faultReport != NULL)
+	faultStats = new FaultStats(faultReport);
+    sharedMemory = new SharedMemory();
 #endif
 
 #ifdef FILESYS
@@ -225,11 +361,37 @@ Cleanup()
 // 2007, Jose Miguel Santos Espino
     delete preemptiveScheduler;
 
+    accounting->WriteReport();		// while address spaces are still
+					// around; not deleted, threads
+					// still point to their accounts
+
 #ifdef NETWORK
     delete postOffice;
 #endif
 
+#ifdef VM
+    if (swapCache != NULL) {
+	swapCache->Print();
+	delete swapCache;
+    }
+    if (faultStats != NULL) {
+	faultStats->WriteReport();
+	delete faultStats;
+    }
+    sharedMemory->Print();
+
+#endif
+
 #ifdef USER_PROGRAM
+    consoleBuffer->Flush();
+    PrintSyscallStats();
+    consoleBuffer->Print();
+    delete consoleBuffer;
+    execCache->Print();
+    delete execCache;
+    delete futexes;
+    delete asyncRequests;
+    delete processTable;
     delete machine;
 #endif
 
@@ -242,8 +404,19 @@ Cleanup()
 #endif
 
     delete timer;
+    hostIO->Print();
+    delete hostIO;
+    alarmClock->Print();
+    delete alarmClock;
+    scheduler->PrintStats();
     delete scheduler;
+    if (synchProfiler != NULL)
+	synchProfiler->Print();		// not deleted: primitives not yet
+					// deleted still count into it
+    interrupt->PrintStats();
     delete interrupt;
+    stackPool->Print();		// not deleted: we may be running on
+				// one of its stacks
 
     Exit(0);
 }
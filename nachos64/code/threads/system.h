@@ -15,6 +15,11 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "hostio.h"
+#include "stackpool.h"
+#include "alarm.h"
+#include "synchprof.h"
+#include "accounting.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -28,6 +33,12 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern HostIO *hostIO;				// input for the devices
+extern StackPool *stackPool;			// thread execution stacks
+extern Alarm *alarmClock;			// sleeping threads
+extern SynchProfiler *synchProfiler;		// synchronization contention
+extern Accounting *accounting;			// usage of each thread and
+						// address space
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -39,7 +50,30 @@ extern int indexTLBSndChc;
 extern int indexSWAPSndChc;
 extern int indexSWAPFIFO;
 extern TranslationEntry* IPT[NumPhysPages];
+extern AddrSpace* IPTOwner[NumPhysPages];	// address space of each frame
+extern AddrSpace* TLBOwner;	// address space loaded in the TLB (or the
+				// page table register), saved lazily
 extern bool threadFirstTime;
+#include "execcache.h"
+extern ExecCache* execCache;	// images of the programs launched
+#include "proctable.h"
+extern ProcessTable* processTable;	// user processes, by SpaceId
+#include "asyncio.h"
+extern AsyncIOTable* asyncRequests;	// ReadAsync and WriteAsync requests
+#include "futex.h"
+extern FutexTable* futexes;	// threads sleeping on user semaphores
+#include "consolebuffer.h"
+extern ConsoleBuffer* consoleBuffer;	// user console input and output
+#endif
+
+#ifdef VM
+#include "swapcache.h"
+extern SwapCache* swapCache;	// compressed pages in front of the swap file
+#include "faultstats.h"
+extern FaultStats* faultStats;	// page fault telemetry
+#include "sharedmem.h"
+extern SharedMemory* sharedMemory;	// shared memory segments
+extern SharedSegment* IPTSegment[NumPhysPages];	// segment of each frame
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB
@@ -38,12 +38,22 @@ Thread::Thread(const char* threadName)
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+    priority = 0;
+    schedLevel = 0;
+    schedUsed = 0;
+    readySince = 0;
+    queueNext = NULL;
+    account = accounting->Open(ThreadAccount, threadName, this);
+    blockedSince = 0;
+#ifdef USER_PROGRAM
     mytable = new NachosOpenFilesTable();
     mytable->addThread();
     mySems = new NachosSems();
     mySems->addSem();
-#ifdef USER_PROGRAM
     space = NULL;
+    process = NULL;
+    for (int i = 0; i < NumTotalRegs; i++)
+	userRegisters[i] = 0;
 #endif
 }
 
@@ -62,12 +72,16 @@ Thread::Thread(const char* threadName)
 Thread::~Thread()
 {
     DEBUG('t', "Deleting thread \"%s\"\n", name);
-    mytable->delThread();
+#ifdef USER_PROGRAM
+    if (mytable != NULL)		// Exit already gave up the files
+	mytable->delThread();
     mySems->delSem();
+#endif
 
     ASSERT(this != currentThread);
     if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(HostMemoryAddress));
+	stackPool->Free(stack);
+    accounting->Close(account);
 }
 
 //----------------------------------------------------------------------
@@ -84,7 +98,8 @@ Thread::~Thread()
 //		1. Allocate a stack
 //		2. Initialize the stack so that a call to SWITCH will
 //		cause it to run the procedure
-//		3. Put the thread on the ready queue
+//		3. Put the thread on the ready queue, with the priority
+//		of the thread that forks it
 //
 //	"func" is the procedure to run concurrently.
 //	"arg" is a single argument to be passed to the procedure.
@@ -103,6 +118,7 @@ Thread::Fork(VoidFunctionPtr func, void* arg)
 #endif
 
     StackAllocate(func, arg);
+    priority = schedLevel = currentThread->getPriority();
 
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
     scheduler->ReadyToRun(this);	// ReadyToRun assumes that interrupts
@@ -110,6 +126,25 @@ Thread::Fork(VoidFunctionPtr func, void* arg)
     interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::setPriority
+// 	Change the highest MLFQ level the thread may run at.  If it is
+//	running above the new priority, it drops to it right away.
+//
+//	"newPriority" is between 0 (most urgent) and MaxPriority.
+//----------------------------------------------------------------------
+
+void
+Thread::setPriority(int newPriority)
+{
+    ASSERT(newPriority >= 0 && newPriority <= MaxPriority);
+    priority = newPriority;
+    if (schedLevel < priority) {
+	schedLevel = priority;
+	schedUsed = 0;
+    }
+}
+
 //----------------------------------------------------------------------
 // Thread::CheckOverflow
 // 	Check a thread's stack to see if it has overrun the space
@@ -228,6 +263,7 @@ Thread::Sleep ()
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
+    blockedSince = stats->totalTicks;
     while ((nextThread = scheduler->FindNextToRun()) == NULL) {
 	interrupt->Idle();	// no one to run, wait for an interrupt
     }
@@ -248,7 +284,7 @@ static void InterruptEnable() { interrupt->Enable(); }
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
-//	Allocate and initialize an execution stack.  The stack is
+//	Allocate and initialize an execution stack, from the stack pool.  The stack is
 //	initialized with an initial stack frame for ThreadRoot, which:
 //		enables interrupts
 //		calls (*func)(arg)
@@ -261,10 +297,10 @@ static void InterruptEnable() { interrupt->Enable(); }
 void
 Thread::StackAllocate (VoidFunctionPtr func, void* arg)
 {
-    stack = (HostMemoryAddress *) AllocBoundedArray(StackSize * sizeof(HostMemoryAddress));
+    stack = stackPool->Allocate();
 
     // i386 & MIPS & SPARC stack works from high addresses to low addresses
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackPool->StackWords() - 4;	// -4 to be on the safe side!
 
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
@@ -290,29 +326,27 @@ Thread::StackAllocate (VoidFunctionPtr func, void* arg)
 //
 //	Note that a user program thread has *two* sets of CPU registers --
 //	one for its state while executing user code, one for its state
-//	while executing kernel code.  This routine saves the former.
+//	while executing kernel code.  The former is "userRegisters", which
+//	the machine works on directly while the thread runs, so there is
+//	nothing to copy.
 //----------------------------------------------------------------------
 
 void
 Thread::SaveUserState()
 {
-    for (int i = 0; i < NumTotalRegs; i++)
-	userRegisters[i] = machine->ReadRegister(i);
+    machine->linked = false;		// an LL/SC sequence can't survive a
+					// context switch
 }
 
 //----------------------------------------------------------------------
 // Thread::RestoreUserState
-//	Restore the CPU state of a user program on a context switch.
-//
-//	Note that a user program thread has *two* sets of CPU registers --
-//	one for its state while executing user code, one for its state
-//	while executing kernel code.  This routine restores the former.
+//	Restore the CPU state of a user program on a context switch, by
+//	pointing the machine at this thread's register set.
 //----------------------------------------------------------------------
 
 void
 Thread::RestoreUserState()
 {
-    for (int i = 0; i < NumTotalRegs; i++)
-	machine->WriteRegister(i, userRegisters[i]);
+    machine->registers = userRegisters;
 }
 #endif
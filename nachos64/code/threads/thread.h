@@ -24,7 +24,7 @@
 //	that your thread stacks are too small.)
 //
 //	One thing to try if you find yourself with seg faults is to
-//	increase the size of thread stack -- ThreadStackSize.
+//	increase the size of thread stack -- StackSize, or "-ss".
 //
 //  	In this interface, forking a thread takes two steps.
 //	We must first allocate a data structure for it: "t = new Thread".
@@ -45,15 +45,19 @@
 #include "addrspace.h"
 #include "nachostabla.h"
 #include "NachosSems.h"
+
+class Process;
 #endif
 
+class Account;
+
 // CPU register state to be saved on context switch.
 // x86 processors needs 9 32-bit registers, whereas x64 has 8 extra registers
 // We allocate room for the maximum of these two architectures
 const int MachineStateSize = 17;
 
 
-// Size of the thread's private execution stack.
+// Default size of the thread's private execution stack; "-ss" changes it.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = 4 * 1024;	// in words
 
@@ -81,8 +85,10 @@ class Thread {
 
 
   public:
+#ifdef USER_PROGRAM
     NachosOpenFilesTable* mytable;
     NachosSems* mySems;
+#endif
     Thread(const char* debugName);	// initialize a Thread
     ~Thread();
 	 				// deallocate a Thread
@@ -102,9 +108,24 @@ class Thread {
     void CheckOverflow();   			// Check if thread has
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     const char* getName() { return (name); }
     void Print() { printf("%s, ", name); }
 
+    int getPriority() { return priority; }
+    void setPriority(int newPriority);	// 0 is the most urgent
+
+    // Scheduling state, kept by the scheduler's policy
+    int schedLevel;			// MLFQ level the thread is at
+    int schedUsed;			// ticks of its quantum used so far
+    long long readySince;		// when it was last put on the
+					// ready list
+    Thread* queueNext;			// next thread on the ThreadQueue
+					// it is on, ready or waiting
+
+    Account* account;			// what it has used, see accounting.h
+    long long blockedSince;		// when it last went to sleep
+
   private:
     // some of the private data for this class is listed above
 
@@ -113,6 +134,7 @@ class Thread {
 					// (If NULL, don't deallocate stack)
     ThreadStatus status;		// ready, running or blocked
     const char* name;
+    int priority;			// highest MLFQ level it may run at
 
     void StackAllocate(VoidFunctionPtr func, void* arg);
     					// Allocate a stack for thread.
@@ -130,6 +152,7 @@ class Thread {
     void RestoreUserState();		// restore user-level register state
 
     AddrSpace *space;			// User code this thread is running.
+    Process *process;			// Process it belongs to, or NULL
 #endif
 };
 
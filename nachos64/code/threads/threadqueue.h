@@ -0,0 +1,103 @@
+// threadqueue.h 
+//	Data structures to keep FIFO queues of threads, without allocating.
+//
+//	List<Thread*> allocates a ListElement for every Append.  The ready
+//	lists and the synchronization primitives queue a thread each time
+//	it becomes ready or blocks, so instead the link is kept in the
+//	Thread itself ("queueNext").  This works because a thread is on
+//	at most one queue at a time: it is either ready, or blocked on a
+//	single semaphore, condition or futex.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADQUEUE_H
+#define THREADQUEUE_H
+
+#include "copyright.h"
+#include "thread.h"
+
+// The following class defines a queue of threads, linked through
+// Thread::queueNext.
+
+class ThreadQueue {
+  public:
+    ThreadQueue() { first = last = NULL; }	// initialize the queue
+
+    void Prepend(Thread* thread);	// Put thread at the front
+    void Append(Thread* thread);	// Put thread at the end
+    Thread* Remove();			// Take thread off the front,
+					// NULL if the queue is empty
+
+    void Apply(void (*func)(Thread*));	// Apply "func" to every thread
+    bool IsEmpty() { return first == NULL; }
+
+  private:
+    Thread* first;			// Head of the queue, NULL if empty
+    Thread* last;			// Last thread of the queue
+};
+
+//----------------------------------------------------------------------
+// ThreadQueue::Prepend
+//      Put "thread" at the beginning of the queue.
+//----------------------------------------------------------------------
+
+inline void
+ThreadQueue::Prepend(Thread* thread)
+{
+    thread->queueNext = first;
+    first = thread;
+    if (last == NULL)
+	last = thread;
+}
+
+//----------------------------------------------------------------------
+// ThreadQueue::Append
+//      Put "thread" at the end of the queue.
+//----------------------------------------------------------------------
+
+inline void
+ThreadQueue::Append(Thread* thread)
+{
+    thread->queueNext = NULL;
+    if (last == NULL)
+	first = thread;
+    else
+	last->queueNext = thread;
+    last = thread;
+}
+
+//----------------------------------------------------------------------
+// ThreadQueue::Remove
+//      Remove the first thread from the queue, and return it, or NULL
+//	if the queue is empty.
+//----------------------------------------------------------------------
+
+inline Thread*
+ThreadQueue::Remove()
+{
+    Thread* thread = first;
+
+    if (thread != NULL) {
+	first = thread->queueNext;
+	if (first == NULL)
+	    last = NULL;
+	thread->queueNext = NULL;
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// ThreadQueue::Apply
+//      Apply "func" to every thread on the queue, front to back.
+//----------------------------------------------------------------------
+
+inline void
+ThreadQueue::Apply(void (*func)(Thread*))
+{
+    for (Thread* thread = first; thread != NULL; thread = thread->queueNext)
+	func(thread);
+}
+
+#endif // THREADQUEUE_H
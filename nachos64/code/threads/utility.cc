@@ -64,3 +64,27 @@ DEBUG(char flag, const char *format, ...)
 	fflush(stdout);
     }
 }
+
+//----------------------------------------------------------------------
+// WriteJSONString
+//      Write "s" to "out" between double quotes, escaping the quotes,
+//	backslashes and control characters, so any thread or program
+//	name can go into a JSON report.
+//----------------------------------------------------------------------
+
+void
+WriteJSONString(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s != '\0'; s++) {
+	unsigned char c = (unsigned char) *s;
+
+	if (c == '"' || c == '\\')
+	    fprintf(out, "\\%c", c);
+	else if (c < 0x20)
+	    fprintf(out, "\\u%04x", c);
+	else
+	    fputc(c, out);
+    }
+    fputc('"', out);
+}
@@ -73,6 +73,9 @@ extern bool DebugIsEnabled(char flag); 		// Is this debug flag enabled?
 extern void DEBUG (char flag, const char* format, ...);  	// Print debug message 
 							// if flag is enabled
 
+// Write "s" to "out" as a quoted JSON string, escaping as needed
+extern void WriteJSONString(FILE *out, const char* s);
+
 //----------------------------------------------------------------------
 // ASSERT
 //      If condition is false,  print a message and dump core.
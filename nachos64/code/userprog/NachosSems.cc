@@ -3,10 +3,11 @@
 NachosSems::NachosSems()
 {
   usage = 0;
-  semaphores = new long[MAX_SEMS];
-  openSemsMap = new BitMap(MAX_SEMS);
+  size = INITIAL_SEMS;
+  semaphores = new long[size];
+  openSemsMap = new BitMap(size);
   // initialize pointer in NULL
-  for ( int x = 0; x < MAX_SEMS; ++x )
+  for ( int x = 0; x < size; ++x )
   {
     semaphores[ x ] = -1;
   }
@@ -23,14 +24,39 @@ NachosSems::~NachosSems()
 
 void NachosSems::print()
 {
-  for (int x= 0; x < MAX_SEMS; ++x)
+  for (int x= 0; x < size; ++x)
   printf("Valor en el vector de info: %ld\n", semaphores[x] );
 
 }
 
+void NachosSems::Grow()
+{
+  int newSize = size * 2;
+  long* newSems = new long[newSize];
+  BitMap* newMap = new BitMap(newSize);
+
+  for ( int x = 0; x < newSize; ++x )
+  {
+    newSems[ x ] = ( x < size ) ? semaphores[ x ] : -1;
+    if ( x < size && openSemsMap->Test( x ) )
+      newMap->Mark( x );
+  }
+
+  delete openSemsMap;
+  delete[] semaphores;
+  openSemsMap = newMap;
+  semaphores = newSems;
+  size = newSize;
+}
+
 int NachosSems::registerSem( long s )
 {
   int freeSemSpace = this->openSemsMap->Find();
+  if ( -1 == freeSemSpace )
+  {
+    Grow();
+    freeSemSpace = this->openSemsMap->Find();
+  }
 
   if (-1 != freeSemSpace )
   {
@@ -43,7 +69,7 @@ int NachosSems::registerSem( long s )
 
 long NachosSems::unRegisterSem( int id )
 {
-    if ( semaphores[ id ] != -1 )
+    if ( id >= 0 && id < size && semaphores[ id ] != -1 )
     {
       this->openSemsMap->Clear( id );
       long copy = semaphores[ id ];
@@ -55,6 +81,8 @@ long NachosSems::unRegisterSem( int id )
 long NachosSems::getNachosPointer( int id )
 {
   //print();
+  if ( id < 0 || id >= size )
+    return -1;
   return semaphores[ id ];
 }
 void NachosSems::addSem()
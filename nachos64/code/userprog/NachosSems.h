@@ -4,7 +4,7 @@
 //#include "synch.h"
 #include "bitmap.h"
 
-#define MAX_SEMS 6
+#define INITIAL_SEMS 6	// semaphores in a new table, it grows as needed
 
 class NachosSems
 {
@@ -22,8 +22,11 @@ public:
   private:
   BitMap * openSemsMap;	// A bitmap to control our vector
   long* semaphores;		// A vector with user created semaphores
+  int size;			// Entries in "semaphores"
   int usage;			// How many threads are using this table
 
+  void Grow();			// Double the number of semaphores
+
 };
 
 #endif
@@ -18,29 +18,7 @@
 #include "copyright.h"
 #include "system.h"
 #include "addrspace.h"
-#include "noff.h"
-
-//----------------------------------------------------------------------
-// SwapHeader
-// 	Do little endian to big endian conversion on the bytes in the
-//	object file header, in case the file was generated on a little
-//	endian machine, and we're now running on a big endian machine.
-//----------------------------------------------------------------------
-
-static void
-SwapHeader (NoffHeader *noffH)
-{
-	noffH->noffMagic = WordToHost(noffH->noffMagic);
-	noffH->code.size = WordToHost(noffH->code.size);
-	noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
-	noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
-	noffH->initData.size = WordToHost(noffH->initData.size);
-	noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
-	noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
-	noffH->uninitData.size = WordToHost(noffH->uninitData.size);
-	noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
-	noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
-}
+#include "execcache.h"
 
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
@@ -55,6 +33,10 @@ SwapHeader (NoffHeader *noffH)
 //	only uniprogramming, and we have a single unsegmented page table
 //
 //	"executable" is the file containing the object code to load into memory
+//
+//	The program is not read from "executable" itself, but from its
+//	image in execCache, under the name "filename", so that programs
+//	that are launched again don't have to be read again.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace( AddrSpace* other)
@@ -63,9 +45,22 @@ AddrSpace::AddrSpace( AddrSpace* other)
 	noInitData = other->noInitData;
 	stack = other->stack;
 
-	numPages = other->numPages;
+	// file mappings belong to the thread that created them, so the
+	// child only gets the program and its own stack
+	numPages = other->mapBase;
+	mapBase = numPages;
 	pageTable = new TranslationEntry[ numPages ];
 	filename = other->filename;
+	image = other->image;
+	execCache->Retain( image );
+	account = accounting->Open( SpaceAccount, filename.c_str(), NULL );
+	#ifdef VM
+	for ( int m = 0; m < MaxMappings; ++m )
+	{
+		mappings[ m ] = NULL;
+	}
+	faultRecord = NULL;
+	#endif
 	// iterar menos las 8 paginas de pila
 	long dataAndCodePages = numPages - 8;
 	long index;
@@ -99,22 +94,27 @@ AddrSpace::AddrSpace( AddrSpace* other)
 AddrSpace::AddrSpace(OpenFile *executable, std::string fn )
 {
 
-	NoffHeader noffH;
 	unsigned int i, size;
 	this->filename = fn;
 
-	executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-	if ((noffH.noffMagic != NOFFMAGIC) &&
-	(WordToHost(noffH.noffMagic) == NOFFMAGIC))
-	SwapHeader(&noffH);
-	ASSERT(noffH.noffMagic == NOFFMAGIC);
+	image = execCache->Lookup( fn.c_str() );
+	ASSERT( image != NULL );
+	account = accounting->Open( SpaceAccount, fn.c_str(), NULL );
 
 	// how big is address space?
-	size = noffH.code.size + noffH.initData.size + noffH.uninitData.size
+	size = image->codeSize + image->initDataSize + image->uninitDataSize
 	+ UserStackSize;	// we need to increase the size
 	// to leave room for the stack
 	numPages = divRoundUp(size, PageSize);
 	size = numPages * PageSize;
+	mapBase = numPages;
+	#ifdef VM
+	for ( int m = 0; m < MaxMappings; ++m )
+	{
+		mappings[ m ] = NULL;
+	}
+	faultRecord = NULL;
+	#endif
 
 	//ASSERT(numPages <= NumPhysPages);		// check we're not trying
 	// to run anything too big --
@@ -141,8 +141,8 @@ AddrSpace::AddrSpace(OpenFile *executable, std::string fn )
 		// pages to be read-only
 	}
 
-	initData = divRoundUp(noffH.code.size, PageSize);
-	noInitData = initData + divRoundUp(noffH.initData.size, PageSize);
+	initData = divRoundUp(image->codeSize, PageSize);
+	noInitData = initData + divRoundUp(image->initDataSize, PageSize);
 	stack = numPages - divRoundUp(UserStackSize,PageSize);
 
 	#ifndef VM
@@ -153,32 +153,12 @@ AddrSpace::AddrSpace(OpenFile *executable, std::string fn )
 
 	// then, copy in the code and data segments into memory
 
-	/* Para el segmento de codigo*/
-	int x = noffH.code.inFileAddr;
-	int y = noffH.initData.inFileAddr;
-	int index;
-	int codeNumPages = divRoundUp(noffH.code.size, PageSize);
-	int segmentNumPages = divRoundUp(noffH.initData.size, PageSize);
-
-	DEBUG('a', "Initializing code segment, at 0x%x, size %d, numero de paginas %d\n",
-	noffH.code.virtualAddr, noffH.code.size, codeNumPages);
-
-	for (index = 0; index < codeNumPages; ++ index )
+	/* Para los segmentos de codigo y datos inicializados */
+	DEBUG('a', "Initializing code and data segments, %d pages\n", noInitData);
+	for (i = 0; i < noInitData; ++i )
 	{
-		executable->ReadAt(&(machine->mainMemory[ pageTable[index].physicalPage *PageSize ] ),
-		PageSize, x );
-		x+=PageSize;
-	}
-
-	if (noffH.initData.size > 0) {
-		DEBUG('a', "Initializing data segment, at 0x%x, size %d\n",
-		noffH.initData.virtualAddr, noffH.initData.size);
-		for (index = codeNumPages; index < codeNumPages + segmentNumPages; ++ index )
-		{
-			executable->ReadAt(&(machine->mainMemory[ pageTable[index].physicalPage *PageSize ] ),
-			PageSize, y );
-			y+=PageSize;
-		}
+		execCache->ReadPage( image, i,
+		&(machine->mainMemory[ pageTable[i].physicalPage * PageSize ] ) );
 	}
 	#endif
 }
@@ -190,6 +170,18 @@ AddrSpace::AddrSpace(OpenFile *executable, std::string fn )
 
 AddrSpace::~AddrSpace()
 {
+	if ( TLBOwner == this )	// sus traducciones ya no sirven
+	{
+		#ifdef VM
+		for ( int i = 0; i < TLBSize; ++i )
+		{
+			machine->tlb[ i ].valid = false;
+		}
+		#endif
+		TLBOwner = NULL;
+	}
+	execCache->Release( image );
+	accounting->Close( account );	// unless Exit did
 	delete pageTable;
 }
 
@@ -227,29 +219,24 @@ AddrSpace::InitRegisters()
 
 //----------------------------------------------------------------------
 // AddrSpace::SaveState
-// 	On a context switch, save any machine state, specific
-//	to this address space, that needs saving//
-//	For now, nothing!
+// 	Give up the TLB: copy the use and dirty bits the hardware set
+//	back into the page table, and invalidate every entry.
+//
+//	Not called on every context switch, but only by RestoreState,
+//	when another address space takes over the TLB.  Switching to a
+//	kernel thread and back leaves the TLB alone.
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState()
 {
 	#ifdef VM
-	DEBUG ( 't', "\nSe salva el estado del hilo: %s\n", currentThread->getName() );
+	DEBUG ( 't', "\nSe salva el estado del espacio de %s\n", filename.c_str() );
 	for(int i = 0; i < TLBSize; ++i){
+		if ( !machine->tlb[i].valid ) {	// entrada nunca cargada
+			continue;
+		}
 		pageTable[machine->tlb[i].virtualPage].use = machine->tlb[i].use;
 		pageTable[machine->tlb[i].virtualPage].dirty = machine->tlb[i].dirty;
-	}
-	/*
-	if (machine->tlb != NULL)
-	{
-		delete [] machine->tlb;
-		machine->tlb = NULL;
-	}
-	*/
-	machine->tlb = new TranslationEntry[ TLBSize ];
-	for (int i = 0; i < TLBSize; ++i)
-	{
 		machine->tlb[i].valid = false;
 	}
 	#endif
@@ -260,32 +247,31 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//	If the TLB already holds this space, there is nothing to do;
+//	otherwise the space that holds it saves it first.  Without VM,
+//	tell the machine where to find the page table.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState()
 {
+	if ( TLBOwner == this )
+	{
+		return;
+	}
 	DEBUG ( 't', "\nSe restaura el estado del hilo: %s\n", currentThread->getName() );
 	#ifndef VM
 	machine->pageTable = pageTable;
 	machine->pageTableSize = numPages;
 	#else
+	if ( TLBOwner != NULL )
+	{
+		TLBOwner->SaveState();
+	}
 	indexTLBFIFO = 0;
 	indexTLBSndChc = 0;
 	threadFirstTime = true;
-	/*
-	if (machine->tlb != NULL)
-	{
-		delete [] machine->tlb;
-		machine->tlb = NULL;
-	}
-	*/
-	machine->tlb = new TranslationEntry[ TLBSize ];
-	for (int i = 0; i < TLBSize; ++i)
-	{
-		machine->tlb[i].valid = false;
-	}
 	#endif
+	TLBOwner = this;
 }
 
 void AddrSpace::clearPhysicalPage( int physicalPage )
@@ -333,6 +319,15 @@ void AddrSpace::showTLBState()
 }
 
 void AddrSpace::writeIntoSwap( int physicalPageVictim ){
+	#ifdef VM
+	// las paginas de archivos mapeados vuelven a su archivo, no al SWAP
+	AddrSpace* owner = IPTOwner[ physicalPageVictim ];
+	if ( owner != NULL && owner->isMappedPage( IPT[physicalPageVictim]->virtualPage ) )
+	{
+		owner->writeBackMappedPage( physicalPageVictim );
+		return;
+	}
+	#endif
 	int swapPage = SWAPBitMap->Find();
 	if ( physicalPageVictim < 0 || physicalPageVictim >= NumPhysPages )
 	{
@@ -352,6 +347,19 @@ void AddrSpace::writeIntoSwap( int physicalPageVictim ){
 	}
 	IPT[physicalPageVictim]->valid = false;
 	IPT[physicalPageVictim]->physicalPage = swapPage;
+	#ifdef VM
+	// una pagina compartida sale de todos los espacios que la usan
+	SharedSegment* segment = IPTSegment[ physicalPageVictim ];
+	if ( segment != NULL )
+	{
+		IPTSegment[ physicalPageVictim ] = NULL;
+		segment->PageOut( IPT[ physicalPageVictim ] - segment->pages );
+	}
+	#endif
+	#ifdef VM
+	// el cache comprimido se queda con la pagina si tiene espacio
+	if ( swapCache == NULL || !swapCache->Put( swapPage, &machine->mainMemory[physicalPageVictim*PageSize] ) )
+	#endif
 	swapFile->WriteAt((&machine->mainMemory[physicalPageVictim*PageSize]),PageSize, swapPage*PageSize);
 	MemBitMap->Clear( indexSWAPFIFO );
 	//clearPhysicalPage( indexSWAPFIFO );
@@ -379,6 +387,9 @@ void AddrSpace::readFromSwap( int physicalPage , int swapPage ){
 			DEBUG( 'v', "Error(readFromSwap): Direccion fisica de memoria inválida: %d\n", physicalPage );
 			ASSERT( false );
 	}
+	#ifdef VM
+	if ( swapCache == NULL || !swapCache->Get( swapPage, &machine->mainMemory[physicalPage*PageSize] ) )
+	#endif
 	swapFile->ReadAt((&machine->mainMemory[physicalPage*PageSize]), PageSize, swapPage*PageSize);
 	++stats->numPageFaults;
 	//++stats->numDiskReads;
@@ -514,6 +525,9 @@ void AddrSpace::updateSwapVictimInfo( int swapIndex )
 			break;
 		}
 	}
+	#ifdef VM
+	if ( faultStats != NULL ) faultStats->Evicted( IPT[swapIndex]->dirty );
+	#endif
 }
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -525,25 +539,33 @@ void AddrSpace::load( unsigned int vpn )
 	DEBUG('v', "\tCodigo va de [%d, %d[ \n", 0, initData);
 	DEBUG('v',"\tDatos incializados va de [%d, %d[ \n", initData, noInitData);
 	DEBUG('v', "\tDatos no incializados va de [%d, %d[ \n", noInitData , stack);
-	DEBUG('v',"\tPila va de [%d, %d[ \n", stack, numPages );
+	DEBUG('v',"\tPila va de [%d, %d[ \n", stack, mapBase );
 
+	if ( vpn >= numPages ){
+		printf("%s %d\n", "Algo muy malo paso, el numero de pagina invalido!", vpn);
+		ASSERT(false);
+	}
+
+	#ifdef VM
+	//Si la pagina pertenece a un archivo mapeado se carga de ese archivo
+	if ( !pageTable[vpn].valid && isMappedPage( vpn ) ){
+		loadMappedPage( vpn );
+		return;
+	}
+	#endif
 	//Si la pagina no es valida ni esta sucia.
 	if ( !pageTable[vpn].valid && !pageTable[vpn].dirty ){
 		//Entonces dependiendo del segmento de la pagina, debo tomar la decisión de ¿donde cargar esta pagina?
 		DEBUG('v', "\t1-La pagina es invalida y limpia\n");
 		DEBUG('v', "\tArchivo fuente: %s\n", filename.c_str());
 		++stats->numPageFaults;
-		OpenFile* executable = fileSystem->Open( filename.c_str() );
-		if (executable == NULL) {
-			DEBUG('v',"Unable to open source file %s\n", filename.c_str() );
-			ASSERT(false);
-		}
-		NoffHeader noffH;
-		executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
 
 		//Nesecito verificar a cual segemento pertenece la pagina.
 		if(vpn >= 0 && vpn < initData){ //segemento de Codigo
 			DEBUG('v', "\t1.1 Página de código\n");
+			#ifdef VM
+			if ( faultStats != NULL ) faultStats->SetKind( ExecutableFault );
+			#endif
 			//Se debe cargar la pagina del archivo ejecutable.
 			freeFrame = MemBitMap->Find();
 
@@ -551,13 +573,14 @@ void AddrSpace::load( unsigned int vpn )
 			{
 				DEBUG('v',"\tFrame libre en memoria: %d\n", freeFrame );
 				pageTable[ vpn ].physicalPage = freeFrame;
-				executable->ReadAt(&(machine->mainMemory[ ( freeFrame * PageSize ) ] ),
-				PageSize, noffH.code.inFileAddr + PageSize*vpn );
+				execCache->ReadPage( image, vpn,
+				&(machine->mainMemory[ ( freeFrame * PageSize ) ] ) );
 				pageTable[ vpn ].valid = true;
 				//pageTable[ vpn ].readOnly = true;
 
 				//Se actualiza la TLB invertida
 				IPT[freeFrame] = &(pageTable[ vpn ]);
+				IPTOwner[ freeFrame ] = this;
 				//Se debe actualizar el TLB
 				int tlbSPace = getNextSCTLB();
 				useThisTLBIndex( tlbSPace, vpn );
@@ -585,12 +608,13 @@ void AddrSpace::load( unsigned int vpn )
 					// actualizar la pagina física para la nueva virtual vpn
 					pageTable[ vpn ].physicalPage = freeFrame;
 					//  cargar el código a la memoria
-					executable->ReadAt(&(machine->mainMemory[ ( freeFrame * PageSize ) ] ),
-					PageSize, noffH.code.inFileAddr + PageSize*vpn );
+					execCache->ReadPage( image, vpn,
+					&(machine->mainMemory[ ( freeFrame * PageSize ) ] ) );
 					// actualizar la validez
 					pageTable[ vpn ].valid = true;
 					// actualizar la tabla de paginas invertidas
 					IPT[ freeFrame ] = &( pageTable[ vpn ] );
+					IPTOwner[ freeFrame ] = this;
 					// finalmente, actualizar tlb
 					int tlbSPace = getNextSCTLB();
 					useThisTLBIndex( tlbSPace, vpn );
@@ -613,10 +637,11 @@ void AddrSpace::load( unsigned int vpn )
 					}
 					//++stats->numPageFaults;
 					pageTable[ vpn ].physicalPage = freeFrame;
-					executable->ReadAt(&(machine->mainMemory[ ( freeFrame * PageSize ) ] ),
-					PageSize, noffH.code.inFileAddr + PageSize*vpn );
+					execCache->ReadPage( image, vpn,
+					&(machine->mainMemory[ ( freeFrame * PageSize ) ] ) );
 					pageTable[ vpn ].valid = true;
 					IPT[ freeFrame ] = &(pageTable [ vpn ]);
+					IPTOwner[ freeFrame ] = this;
 					int tlbSPace = getNextSCTLB();
 					useThisTLBIndex( tlbSPace, vpn );
 				}
@@ -626,6 +651,9 @@ void AddrSpace::load( unsigned int vpn )
 		else if(vpn >= initData && vpn < noInitData){ //segmento de Datos Inicializados.
 			//Se debe cargar la pagina del archivo ejecutable.
 			DEBUG('v', "\t1.2 Página de datos Inicializados\n");
+			#ifdef VM
+			if ( faultStats != NULL ) faultStats->SetKind( ExecutableFault );
+			#endif
 			freeFrame = MemBitMap->Find();
 
 			if ( freeFrame != -1  )
@@ -633,12 +661,13 @@ void AddrSpace::load( unsigned int vpn )
 				DEBUG('v',"Frame libre en memoria: %d\n", freeFrame );
 				//++stats->numPageFaults;
 				pageTable[ vpn ].physicalPage = freeFrame;
-				executable->ReadAt(&(machine->mainMemory[ ( freeFrame * PageSize ) ] ),
-				PageSize, noffH.code.inFileAddr + PageSize*vpn );
+				execCache->ReadPage( image, vpn,
+				&(machine->mainMemory[ ( freeFrame * PageSize ) ] ) );
 				pageTable[ vpn ].valid = true;
 
 				//Se actualiza la TLB invertida
 				IPT[freeFrame] = &(pageTable[ vpn ]);
+				IPTOwner[ freeFrame ] = this;
 				//Se debe actualizar el TLB
 				int tlbSPace = getNextSCTLB();
 				useThisTLBIndex( tlbSPace, vpn );
@@ -667,12 +696,13 @@ void AddrSpace::load( unsigned int vpn )
 						// asignar al pageTable[vpn] es freeFrame
 						pageTable[ vpn ].physicalPage = freeFrame;
 						// leer del archivo ejecutable
-						executable->ReadAt(&(machine->mainMemory[ ( freeFrame * PageSize ) ] ),
-						PageSize, noffH.code.inFileAddr + PageSize*vpn );
+						execCache->ReadPage( image, vpn,
+						&(machine->mainMemory[ ( freeFrame * PageSize ) ] ) );
 						//poner valida la paginas
 						pageTable[ vpn ].valid = true;
 						//actualiza la tabla de paginas invertidas
 						IPT[ freeFrame ] = &( pageTable[ vpn ] );
+						IPTOwner[ freeFrame ] = this;
 						//hacer la actualización en la tlb
 						int tlbSPace = getNextSCTLB();
 						useThisTLBIndex( tlbSPace, vpn );
@@ -698,12 +728,13 @@ void AddrSpace::load( unsigned int vpn )
 						//asignar ese freeFrame al pageTable[vpn]
 						pageTable[ vpn ].physicalPage = freeFrame;
 						//leer del archivo ejecutable
-						executable->ReadAt(&(machine->mainMemory[ ( freeFrame * PageSize ) ] ),
-						PageSize, noffH.code.inFileAddr + PageSize*vpn );
+						execCache->ReadPage( image, vpn,
+						&(machine->mainMemory[ ( freeFrame * PageSize ) ] ) );
 						//valida dicha pageTable[vpn]
 						pageTable[ vpn ].valid = true;
 						//actualizar tabla de paginas invertidas
 						IPT[ freeFrame ] = &(pageTable [ vpn ]);
+						IPTOwner[ freeFrame ] = this;
 						// actualizar la tlp
 						int tlbSPace = getNextSCTLB();
 						useThisTLBIndex( tlbSPace, vpn );
@@ -711,8 +742,11 @@ void AddrSpace::load( unsigned int vpn )
 				//ASSERT(false);
 			}
 		}
-		else if(vpn >= noInitData && vpn < numPages){ //segemento de Datos No Inicializados o segmento de Pila.
+		else if(vpn >= noInitData && vpn < mapBase){ //segemento de Datos No Inicializados o segmento de Pila.
 			DEBUG('v',"\t1.3 Página de datos no Inicializado o página de pila\n");
+			#ifdef VM
+			if ( faultStats != NULL ) faultStats->SetKind( ZeroFillFault );
+			#endif
 			freeFrame = MemBitMap->Find();
 			DEBUG('v',"\t\t\tSe busca una nueva página para otorgar\n" );
 			if ( freeFrame != -1 )
@@ -724,6 +758,7 @@ void AddrSpace::load( unsigned int vpn )
 				//Se actualiza la TLB invertida
 				//clearPhysicalPage(freeFrame);
 				IPT[freeFrame] = &(pageTable[ vpn ]);
+				IPTOwner[ freeFrame ] = this;
 
 				//Se debe actualizar el TLB
 				int tlbSPace = getNextSCTLB();
@@ -756,6 +791,7 @@ void AddrSpace::load( unsigned int vpn )
 
 					//actualizo invertida
 					IPT[ freeFrame ] = &(pageTable [ vpn ]);
+					IPTOwner[ freeFrame ] = this;
 
 					//actualizo el tlb
 					int tlbSPace = getNextSCTLB();
@@ -782,6 +818,8 @@ void AddrSpace::load( unsigned int vpn )
 					pageTable [ vpn ].valid = true;
 
 					IPT[ freeFrame ] = &(pageTable [ vpn ]);
+
+					IPTOwner[ freeFrame ] = this;
 					// finalmente se actualiza la tlb
 					int tlbSPace = getNextSCTLB();
 					useThisTLBIndex( tlbSPace, vpn );
@@ -793,13 +831,14 @@ void AddrSpace::load( unsigned int vpn )
 			printf("%s %d\n", "Algo muy malo paso, el numero de pagina invalido!", vpn);
 			ASSERT(false);
 		}
-		// Se cierra el Archivo
-		delete executable;
 	}
 	//Si la pagina no es valida y esta sucia.
 	else if(!pageTable[vpn].valid && pageTable[vpn].dirty){
 		//Debo traer la pagina del area de SWAP.
 		DEBUG('v', "\t2- Pagina invalida y sucia\n");
+		#ifdef VM
+		if ( faultStats != NULL ) faultStats->SetKind( SwapInFault );
+		#endif
 		DEBUG('v', "\t\tPagina física: %d, pagina virtual= %d\n", pageTable[vpn].physicalPage, pageTable[vpn].virtualPage );
 		freeFrame = MemBitMap->Find();
 		if(freeFrame != -1)
@@ -815,6 +854,7 @@ void AddrSpace::load( unsigned int vpn )
 			pageTable [ vpn ].valid = true;
 			// actualiza tabla de paginas invertidas
 			IPT[ freeFrame ] = &(pageTable [ vpn ]);
+			IPTOwner[ freeFrame ] = this;
 			//actualizar su posición en la tlb
 			int tlbSPace = getNextSCTLB();
 			useThisTLBIndex( tlbSPace, vpn );
@@ -846,6 +886,7 @@ void AddrSpace::load( unsigned int vpn )
 				readFromSwap( freeFrame, oldSwapPageAddr );
 				pageTable [ vpn ].valid = true;
 				IPT[ freeFrame ] = &(pageTable [ vpn ]);
+				IPTOwner[ freeFrame ] = this;
 
 				// finalmente actualizacom tlb
 				int tlbSPace = getNextSCTLB();
@@ -871,6 +912,7 @@ void AddrSpace::load( unsigned int vpn )
 				readFromSwap( freeFrame, oldSwapPageAddr );
 				pageTable [ vpn ].valid = true;
 				IPT[ freeFrame ] = &(pageTable [ vpn ]);
+				IPTOwner[ freeFrame ] = this;
 				// finalmente actualizacom tlb
 				int tlbSPace = getNextSCTLB();
 				useThisTLBIndex( tlbSPace, vpn );
@@ -893,3 +935,461 @@ void AddrSpace::load( unsigned int vpn )
 		useThisTLBIndex( tlbSPace, vpn );
 	}
 }
+
+#ifdef VM
+//////////////A partir de aquí comienzan los métodos para archivos mapeados (Mmap)///////////////////////////////////
+
+//----------------------------------------------------------------------
+// AddrSpace::findMapping
+// 	Return the index in "mappings" of the region that contains
+//	virtual page "vpn", or -1 if the page isn't mapped from a file.
+//----------------------------------------------------------------------
+
+int AddrSpace::findMapping( unsigned int vpn )
+{
+	if ( vpn < mapBase )
+	{
+		return -1;
+	}
+	for ( int m = 0; m < MaxMappings; ++m )
+	{
+		if ( mappings[ m ] != NULL && vpn >= mappings[ m ]->firstPage
+		&& vpn < mappings[ m ]->firstPage + mappings[ m ]->numPages )
+		{
+			return m;
+		}
+	}
+	return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::getFreeFrame
+// 	Return a free physical page, evicting a victim chosen by second
+//	chance if memory is full.  Dirty victims go to the swap (or back
+//	to their file, if they are mapped), clean ones are just dropped.
+//----------------------------------------------------------------------
+
+int AddrSpace::getFreeFrame()
+{
+	int freeFrame = MemBitMap->Find();
+	if ( freeFrame != -1 )
+	{
+		return freeFrame;
+	}
+	indexSWAPFIFO = getNextSCSWAP();
+	updateSwapVictimInfo( indexSWAPFIFO );
+	if ( IPT[indexSWAPFIFO]->dirty )
+	{
+		DEBUG('v',"\t\t\tVictima f=%d,l=%d sucia\n",IPT[indexSWAPFIFO]->physicalPage, IPT[indexSWAPFIFO]->virtualPage );
+		writeIntoSwap( IPT[indexSWAPFIFO]->physicalPage );
+	}else
+	{
+		DEBUG('v',"\t\t\tVictima f=%d,l=%d limpia\n",IPT[indexSWAPFIFO]->physicalPage, IPT[indexSWAPFIFO]->virtualPage );
+		int oldPhysicalPage = IPT[indexSWAPFIFO]->physicalPage;
+		IPT[indexSWAPFIFO]->valid = false;
+		IPT[indexSWAPFIFO]->physicalPage = -1;
+		MemBitMap->Clear( oldPhysicalPage );
+	}
+	freeFrame = MemBitMap->Find();
+	if ( freeFrame == -1 )
+	{
+		printf("Invalid free frame %d\n", freeFrame );
+		ASSERT( false );
+	}
+	return freeFrame;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::loadMappedPage
+// 	Bring in a page of a mapped file on a page fault.  The part of
+//	the page past the end of the mapping is zero filled.
+//----------------------------------------------------------------------
+
+void AddrSpace::loadMappedPage( unsigned int vpn )
+{
+	int m = findMapping( vpn );
+	if ( mappings[ m ]->segment != NULL )
+	{
+		loadSharedPage( m, vpn );
+		return;
+	}
+	MappedRegion *region = mappings[ m ];
+	int offset = ( vpn - region->firstPage ) * PageSize;
+	int freeFrame = getFreeFrame();
+
+	DEBUG('v', "\t5- Pagina de archivo mapeado, offset %d\n", offset );
+	if ( faultStats != NULL ) faultStats->SetKind( FileFillFault );
+	++stats->numPageFaults;
+	clearPhysicalPage( freeFrame );
+	int toRead = region->length - offset;
+	if ( toRead > PageSize )
+	{
+		toRead = PageSize;
+	}
+	region->file->ReadAt( &(machine->mainMemory[ freeFrame * PageSize ]), toRead, offset );
+
+	pageTable[ vpn ].physicalPage = freeFrame;
+	pageTable[ vpn ].valid = true;
+	pageTable[ vpn ].dirty = false;
+	IPT[ freeFrame ] = &(pageTable[ vpn ]);
+	IPTOwner[ freeFrame ] = this;
+	int tlbSPace = getNextSCTLB();
+	useThisTLBIndex( tlbSPace, vpn );
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::loadSharedPage
+// 	Map page "vpn" of the segment attached as region "regionIndex".
+//	If no other space has the page in memory, bring it in first:
+//	from the swap if it was evicted, zero filled if it is new.
+//
+//	The frame table points to the segment's master entry.  Shared
+//	pages are always treated as dirty, since the dirty bit may be in
+//	the TLB of any space that maps them.
+//----------------------------------------------------------------------
+
+void AddrSpace::loadSharedPage( int regionIndex, unsigned int vpn )
+{
+	MappedRegion *region = mappings[ regionIndex ];
+	SharedSegment *segment = region->segment;
+	TranslationEntry *master = &( segment->pages[ vpn - region->firstPage ] );
+
+	if ( !master->valid )
+	{
+		int freeFrame = getFreeFrame();
+		if ( master->dirty )
+		{
+			DEBUG('v', "\t6- Pagina compartida en el swap\n" );
+			if ( faultStats != NULL ) faultStats->SetKind( SwapInFault );
+			readFromSwap( freeFrame, master->physicalPage );
+		}else
+		{
+			DEBUG('v', "\t6- Pagina compartida nueva\n" );
+			if ( faultStats != NULL ) faultStats->SetKind( ZeroFillFault );
+			++stats->numPageFaults;
+			clearPhysicalPage( freeFrame );
+		}
+		master->physicalPage = freeFrame;
+		master->valid = true;
+		master->dirty = true;
+		IPT[ freeFrame ] = master;
+		IPTOwner[ freeFrame ] = NULL;
+		IPTSegment[ freeFrame ] = segment;
+	}else
+	{
+		DEBUG('v', "\t6- Pagina compartida en memoria\n" );
+	}
+	master->use = true;
+	pageTable[ vpn ].physicalPage = master->physicalPage;
+	pageTable[ vpn ].valid = true;
+	pageTable[ vpn ].dirty = true;
+	int tlbSPace = getNextSCTLB();
+	useThisTLBIndex( tlbSPace, vpn );
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::dropSharedPage
+// 	The frame behind shared page "vpn" was evicted; forget it, so
+//	the next access faults and finds the page again.
+//----------------------------------------------------------------------
+
+void AddrSpace::dropSharedPage( unsigned int vpn )
+{
+	if ( this == TLBOwner )
+	{
+		for ( int index = 0; index < TLBSize; ++index )
+		{
+			if ( machine->tlb[ index ].valid && machine->tlb[ index ].virtualPage == (int) vpn )
+			{
+				machine->tlb[ index ].valid = false;
+			}
+		}
+	}
+	pageTable[ vpn ].valid = false;
+	pageTable[ vpn ].dirty = false;
+	pageTable[ vpn ].physicalPage = -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::writeBackMappedPage
+// 	Evict a resident page of a mapped file: write it back to the
+//	file and free its frame.  The page will be read from the file
+//	again on the next fault.
+//----------------------------------------------------------------------
+
+void AddrSpace::writeBackMappedPage( int physicalPage )
+{
+	TranslationEntry *entry = IPT[ physicalPage ];
+	int m = findMapping( entry->virtualPage );
+	ASSERT( m != -1 );
+	releaseMappedPage( m, entry->virtualPage );
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::releaseMappedPage
+// 	Write page "vpn" of mapping "regionIndex" back to its file if it
+//	is dirty, and release its physical page.
+//----------------------------------------------------------------------
+
+void AddrSpace::releaseMappedPage( int regionIndex, unsigned int vpn )
+{
+	MappedRegion *region = mappings[ regionIndex ];
+	TranslationEntry *entry = &(pageTable[ vpn ]);
+	if ( !entry->valid )
+	{
+		return;
+	}
+	// las paginas compartidas se quedan en el segmento
+	if ( region->segment != NULL )
+	{
+		dropSharedPage( vpn );
+		return;
+	}
+	// la TLB puede tener el bit de sucio mas reciente
+	if ( this == TLBOwner )
+	{
+		for ( int index = 0; index < TLBSize; ++index )
+		{
+			if ( machine->tlb[ index ].valid && machine->tlb[ index ].virtualPage == (int) vpn )
+			{
+				entry->dirty = entry->dirty || machine->tlb[ index ].dirty;
+				machine->tlb[ index ].valid = false;
+			}
+		}
+	}
+	int physicalPage = entry->physicalPage;
+	if ( entry->dirty )
+	{
+		int offset = ( vpn - region->firstPage ) * PageSize;
+		int toWrite = region->length - offset;
+		if ( toWrite > PageSize )
+		{
+			toWrite = PageSize;
+		}
+		DEBUG('v', "\t\tSe escribe la pagina %d en su archivo, offset %d\n", vpn, offset );
+		region->file->WriteAt( &(machine->mainMemory[ physicalPage * PageSize ]), toWrite, offset );
+	}
+	entry->valid = false;
+	entry->dirty = false;
+	entry->physicalPage = -1;
+	IPT[ physicalPage ] = NULL;
+	IPTOwner[ physicalPage ] = NULL;
+	MemBitMap->Clear( physicalPage );
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::addMapping
+// 	Make room for a region of "pages" pages from "firstPage" on, and
+//	return its index in "mappings".  The page table grows to make room;
+//	no page is brought in until the program touches it.
+//
+//	Returns -1 if there are too many mappings already, the region
+//	would end more than MaxMappedPages past the stack, or the pages
+//	are not free.
+//----------------------------------------------------------------------
+
+int AddrSpace::addMapping( unsigned int firstPage, unsigned int pages )
+{
+	int m;
+	for ( m = 0; m < MaxMappings && mappings[ m ] != NULL; ++m );
+	if ( m == MaxMappings || pages == 0 || pages > MaxMappedPages || firstPage < mapBase )
+	{
+		return -1;
+	}
+	// firstPage + pages - mapBase > MaxMappedPages, without overflow
+	if ( firstPage - mapBase > MaxMappedPages - pages )
+	{
+		return -1;
+	}
+	for ( int other = 0; other < MaxMappings; ++other )
+	{
+		if ( mappings[ other ] != NULL
+		&& firstPage < mappings[ other ]->firstPage + mappings[ other ]->numPages
+		&& mappings[ other ]->firstPage < firstPage + pages )
+		{
+			return -1;
+		}
+	}
+	if ( firstPage + pages > numPages )
+	{
+		unsigned int newNumPages = firstPage + pages;
+		TranslationEntry *oldTable = pageTable;
+		pageTable = new TranslationEntry[ newNumPages ];
+		for ( unsigned int index = 0; index < numPages; ++index )
+		{
+			pageTable[ index ] = oldTable[ index ];
+		}
+		// la tabla invertida apunta a la tabla vieja
+		for ( int frame = 0; frame < NumPhysPages; ++frame )
+		{
+			if ( IPTOwner[ frame ] == this && IPT[ frame ] >= oldTable && IPT[ frame ] < oldTable + numPages )
+			{
+				IPT[ frame ] = pageTable + ( IPT[ frame ] - oldTable );
+			}
+		}
+		delete [] oldTable;
+		for ( unsigned int index = numPages; index < newNumPages; ++index )
+		{
+			pageTable[ index ].virtualPage = index;
+			pageTable[ index ].physicalPage = -1;
+			pageTable[ index ].valid = false;
+			pageTable[ index ].use = false;
+			pageTable[ index ].dirty = false;
+			pageTable[ index ].readOnly = false;
+		}
+		numPages = newNumPages;
+	}
+
+	mappings[ m ] = new MappedRegion;
+	mappings[ m ]->firstPage = firstPage;
+	mappings[ m ]->numPages = pages;
+	mappings[ m ]->length = pages * PageSize;
+	mappings[ m ]->file = NULL;
+	mappings[ m ]->segment = NULL;
+	return m;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::removeMapping
+// 	Remove mapping "regionIndex": dirty pages of a file go back to
+//	it, and a segment is told it is no longer attached here.
+//----------------------------------------------------------------------
+
+void AddrSpace::removeMapping( int regionIndex )
+{
+	MappedRegion *region = mappings[ regionIndex ];
+	for ( unsigned int page = region->firstPage; page < region->firstPage + region->numPages; ++page )
+	{
+		releaseMappedPage( regionIndex, page );
+	}
+	mappings[ regionIndex ] = NULL;
+	// las paginas despues de la ultima region se pueden volver a usar
+	numPages = mapBase;
+	for ( int m = 0; m < MaxMappings; ++m )
+	{
+		if ( mappings[ m ] != NULL && mappings[ m ]->firstPage + mappings[ m ]->numPages > numPages )
+		{
+			numPages = mappings[ m ]->firstPage + mappings[ m ]->numPages;
+		}
+	}
+	if ( region->segment != NULL )
+	{
+		sharedMemory->Detached( region->segment, this, region->firstPage );
+	}
+	delete region->file;
+	delete region;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::mapFile
+// 	Map the first "length" bytes of "file" after the last mapping.
+//
+//	Returns the virtual address of the mapping, or -1 if there are
+//	too many mappings already.  The address space takes ownership of
+//	"file".
+//----------------------------------------------------------------------
+
+int AddrSpace::mapFile( OpenFile *file, int length )
+{
+	if ( length <= 0 )
+	{
+		return -1;
+	}
+	int m = addMapping( numPages, divRoundUp( length, PageSize ) );
+	if ( m == -1 )
+	{
+		return -1;
+	}
+	mappings[ m ]->length = length;
+	mappings[ m ]->file = file;
+	DEBUG('v', "Mmap: %d bytes en las paginas [%d, %d[\n", length, mappings[ m ]->firstPage, numPages );
+	return mappings[ m ]->firstPage * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::unmapFile
+// 	Remove the mapping that starts at "virtAddr", writing its dirty
+//	pages back to the file.  Returns 0, or -1 if no file is mapped
+//	there.
+//----------------------------------------------------------------------
+
+int AddrSpace::unmapFile( int virtAddr )
+{
+	if ( virtAddr < 0 || virtAddr % PageSize != 0 )
+	{
+		return -1;
+	}
+	unsigned int vpn = virtAddr / PageSize;
+	int m = findMapping( vpn );
+	if ( m == -1 || mappings[ m ]->firstPage != vpn || mappings[ m ]->file == NULL )
+	{
+		return -1;
+	}
+	removeMapping( m );
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::attachSegment
+// 	Map shared memory segment "segment" at "virtAddr", which must be
+//	page aligned and past the stack, or after the last mapping if
+//	"virtAddr" is 0.  Returns the address of the segment, or -1.
+//----------------------------------------------------------------------
+
+int AddrSpace::attachSegment( SharedSegment *segment, int virtAddr )
+{
+	if ( virtAddr < 0 || virtAddr % PageSize != 0 )
+	{
+		return -1;
+	}
+	unsigned int firstPage = ( virtAddr == 0 ) ? numPages : virtAddr / PageSize;
+	int m = addMapping( firstPage, segment->numPages );
+	if ( m == -1 )
+	{
+		return -1;
+	}
+	mappings[ m ]->segment = segment;
+	sharedMemory->Attached( segment, this, firstPage );
+	DEBUG('v', "ShmAttach: segmento %d en las paginas [%d, %d[\n", segment->id, firstPage, firstPage + segment->numPages );
+	return firstPage * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::detachSegment
+// 	Remove the segment attached at "virtAddr".  Returns 0, or -1 if
+//	no segment is attached there.
+//----------------------------------------------------------------------
+
+int AddrSpace::detachSegment( int virtAddr )
+{
+	if ( virtAddr < 0 || virtAddr % PageSize != 0 )
+	{
+		return -1;
+	}
+	unsigned int vpn = virtAddr / PageSize;
+	int m = findMapping( vpn );
+	if ( m == -1 || mappings[ m ]->firstPage != vpn || mappings[ m ]->segment == NULL )
+	{
+		return -1;
+	}
+	removeMapping( m );
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::unmapAll
+// 	Remove every mapping and segment, when the thread that owns them
+//	exits.
+//----------------------------------------------------------------------
+
+void AddrSpace::unmapAll()
+{
+	for ( int m = 0; m < MaxMappings; ++m )
+	{
+		if ( mappings[ m ] != NULL )
+		{
+			removeMapping( m );
+		}
+	}
+}
+#endif
@@ -17,7 +17,30 @@
 #include "filesys.h"
 #include <string>
 
+class FaultRecord;
+class Account;
+class ExecImage;
+class SharedSegment;
+
 #define UserStackSize		1024 	// increase this as necessary!
+#define MaxMappings		8	// file mappings per address space
+#define MaxMappedPages		1024	// pages past the stack that the
+					// mappings may reach
+
+// A region of a file mapped into the address space with Mmap.  Its
+// pages are filled on demand from "file" by the page fault handler,
+// and dirty pages are written back to it on eviction or unmap.
+// A shared memory segment attached with ShmAttach is a region too,
+// with no file; its pages come from the segment (see sharedmem.h).
+
+class MappedRegion {
+public:
+  unsigned int firstPage;	// first virtual page of the mapping
+  unsigned int numPages;	// pages in the mapping
+  int length;			// bytes of the file that are mapped
+  OpenFile *file;		// the mapped file, or NULL
+  SharedSegment *segment;	// the attached segment, or NULL
+};
 
 class AddrSpace {
 public:
@@ -41,8 +64,15 @@ public:
   unsigned int noInitData;
   unsigned int stack;
   std::string filename;
+  ExecImage *image;		// the program, shared through execCache
 
   unsigned int numPages;		// Number of pages in the virtual
+  unsigned int mapBase;		// First page after the stack, where
+  				// file mappings start
+  Account *account;		// what its threads have used
+  #ifdef VM
+  FaultRecord *faultRecord;	// page faults taken, for the fault report
+  #endif
 
 private:
   TranslationEntry *pageTable;	// Assume linear page table translation
@@ -66,10 +96,32 @@ private:
   int  getNextSCSWAP();
   void updateSwapVictimInfo( int swapIndex );
 
+  #ifdef VM
+  ///////////para archivos mapeados (Mmap)
+  MappedRegion *mappings[MaxMappings];
+  int  findMapping( unsigned int vpn );
+  int  getFreeFrame();
+  void loadMappedPage( unsigned int vpn );
+  void loadSharedPage( int regionIndex, unsigned int vpn );
+  void releaseMappedPage( int regionIndex, unsigned int vpn );
+  int  addMapping( unsigned int firstPage, unsigned int pages );
+  void removeMapping( int regionIndex );
+  #endif
+
   // for now!
   // address space
 public:
   void load(unsigned int vpn );
+  #ifdef VM
+  int  mapFile( OpenFile *file, int length );	// Mmap, returns the address
+  int  unmapFile( int virtAddr );		// Munmap
+  void unmapAll();				// on Exit
+  bool isMappedPage( unsigned int vpn ) { return findMapping( vpn ) != -1; }
+  void writeBackMappedPage( int physicalPage );	// evict a mapped page
+  int  attachSegment( SharedSegment *segment, int virtAddr );	// ShmAttach
+  int  detachSegment( int virtAddr );		// ShmDetach
+  void dropSharedPage( unsigned int vpn );	// its frame was evicted
+  #endif
 
 };
 
@@ -0,0 +1,87 @@
+// asyncio.cc
+//	Routines to keep track of asynchronous I/O requests.
+
+#include "asyncio.h"
+
+AsyncIOTable::AsyncIOTable()
+{
+	requests = new AsyncIORequest[ MAX_ASYNC_REQUESTS ];
+	for ( int x = 0; x < MAX_ASYNC_REQUESTS; ++x )
+		requests[ x ].done = NULL;
+	requestsMap = new BitMap( MAX_ASYNC_REQUESTS );
+}
+
+AsyncIOTable::~AsyncIOTable()
+{
+	for ( int x = 0; x < MAX_ASYNC_REQUESTS; ++x )
+		delete requests[ x ].done;
+	delete[] requests;
+	delete requestsMap;
+}
+
+int AsyncIOTable::Submit( int op, int buffer, int size, int fileId,
+			  int semId, Process* owner )
+{
+	int owned = 0;
+	for ( int x = 0; x < MAX_ASYNC_REQUESTS; ++x )
+		if ( requestsMap->Test( x ) && requests[ x ].owner == owner )
+			++owned;
+	if ( owned >= MAX_ASYNC_PER_PROCESS )
+		return -1;
+
+	int id = requestsMap->Find();
+	if ( id == -1 )
+		return -1;
+
+	AsyncIORequest* request = &requests[ id ];
+	request->op = op;
+	request->buffer = buffer;
+	request->size = size;
+	request->fileId = fileId;
+	request->semId = semId;
+	request->owner = owner;
+	request->result = -1;
+	if ( request->done == NULL )
+		request->done = new Semaphore( "async IO", 0 );
+	return id;
+}
+
+AsyncIORequest* AsyncIOTable::Get( int id )
+{
+	ASSERT( id >= 0 && id < MAX_ASYNC_REQUESTS && requestsMap->Test( id ) );
+	return &requests[ id ];
+}
+
+void AsyncIOTable::Complete( int id, int result )
+{
+	AsyncIORequest* request = Get( id );
+	request->result = result;
+	request->done->V();
+}
+
+int AsyncIOTable::Wait( int id, Process* owner )
+{
+	if ( id < 0 || id >= MAX_ASYNC_REQUESTS || !requestsMap->Test( id )
+	     || requests[ id ].owner != owner )
+		return -1;
+
+	AsyncIORequest* request = &requests[ id ];
+	request->owner = NULL;		// nobody else may wait for it
+	request->done->P();
+	requestsMap->Clear( id );
+	return request->result;
+}
+
+void AsyncIOTable::Release( Process* owner )
+{
+	// Every worker was a thread of "owner", so they are all done; only
+	// the completions nobody waited for are left
+	for ( int x = 0; x < MAX_ASYNC_REQUESTS; ++x )
+		if ( requestsMap->Test( x ) && requests[ x ].owner == owner )
+		{
+			delete requests[ x ].done;	// it was signaled
+			requests[ x ].done = NULL;
+			requests[ x ].owner = NULL;
+			requestsMap->Clear( x );
+		}
+}
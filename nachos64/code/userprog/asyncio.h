@@ -0,0 +1,63 @@
+// asyncio.h
+//	Data structures to keep track of the asynchronous I/O requests
+//	made with the ReadAsync and WriteAsync system calls.
+//
+//	Each request is served by its own kernel thread (an I/O worker),
+//	which shares the address space, open files and semaphores of the
+//	user thread that made it, and counts as one of the threads of its
+//	process, so the process is not reaped before the transfer is done.  When the transfer is done the worker
+//	stores the result in the request table, signals the user semaphore
+//	given with the request (if any), and wakes up a WaitIO on it.
+//
+//	Request ids are kernel wide; a request can only be waited for by
+//	the process that made it, and is freed by WaitIO, or when the last
+//	thread of the process is done.  A process can only have
+//	MAX_ASYNC_PER_PROCESS requests, so it can't take every id.
+
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include "bitmap.h"
+#include "synch.h"
+
+#define MAX_ASYNC_REQUESTS 64
+#define MAX_ASYNC_PER_PROCESS 16
+
+class Process;
+
+// The following class defines one asynchronous I/O request.
+
+class AsyncIORequest {
+  public:
+    int op;			// SC_Read or SC_Write
+    int buffer;			// user buffer, in Nachos memory
+    int size;			// bytes to transfer
+    int fileId;			// Nachos file handle
+    int semId;			// user semaphore to signal, or -1
+    Process* owner;		// the process that made it
+    int result;			// bytes transferred, or -1
+    Semaphore* done;		// signaled by the worker when finished
+};
+
+class AsyncIOTable {
+  public:
+    AsyncIOTable();		// Initialize
+    ~AsyncIOTable();		// De-allocate
+
+    int Submit( int op, int buffer, int size, int fileId, int semId,
+		Process* owner );	// Register a request, return its
+				// id or -1
+    AsyncIORequest* Get( int id );	// The request with id "id"
+    void Complete( int id, int result );	// The worker is done with it
+    int Wait( int id, Process* owner );	// Wait for the request and
+				// free it, return its result or -1 if
+				// "id" is not a pending request of "owner"
+    void Release( Process* owner );	// Free the requests of "owner",
+				// when none of its threads is left
+
+  private:
+    AsyncIORequest* requests;	// A vector with the requests
+    BitMap* requestsMap;	// A bitmap to control our vector
+};
+
+#endif // ASYNCIO_H
@@ -0,0 +1,175 @@
+// consolebuffer.cc
+//	Routines to buffer the console output of user programs, and to
+//	read the console input ahead.
+
+#include "copyright.h"
+#include "consolebuffer.h"
+
+#include <unistd.h>
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::ConsoleBuffer
+// 	Initialize an empty output ring and input buffer.
+//----------------------------------------------------------------------
+
+ConsoleBuffer::ConsoleBuffer()
+{
+    ringUsed = 0;
+    interactive = isatty(1);
+    inputStart = inputEnd = 0;
+    inputDone = false;
+    numFlushes = numHostReads = 0;
+    bytesWritten = 0;
+}
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::~ConsoleBuffer
+// 	Write out anything still in the ring.
+//----------------------------------------------------------------------
+
+ConsoleBuffer::~ConsoleBuffer()
+{
+    Flush();
+}
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::Append
+// 	Add "size" bytes to the output ring, writing the ring out when
+//	it gets more than half full.
+//----------------------------------------------------------------------
+
+void
+ConsoleBuffer::Append(const char *from, int size)
+{
+    while (size > 0) {
+	int count = ConsoleRingSize - ringUsed;
+	if (count > size)
+	    count = size;
+	memcpy(ring + ringUsed, from, count);
+	ringUsed += count;
+	from += count;
+	size -= count;
+	if (ringUsed > ConsoleRingSize / 2)
+	    Flush();
+    }
+}
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::Write
+// 	Write "size" bytes of output for a process.  Whole lines go to
+//	the ring; the last partial line waits in the process' "line".
+//	The ring goes out to the host when it fills up, or, if a person
+//	is watching the console, as soon as a line is complete.
+//----------------------------------------------------------------------
+
+void
+ConsoleBuffer::Write(ConsoleLine *line, const char *from, int size)
+{
+    bool newLine = false;
+
+    if (line == NULL) {
+	Append(from, size);
+	newLine = (memchr(from, '\n', size) != NULL);
+    } else
+	for (int i = 0; i < size; i++) {
+	    line->data[line->used++] = from[i];
+	    if (from[i] == '\n')
+		newLine = true;
+	    if (from[i] == '\n' || line->used == ConsoleLineSize)
+		EndLine(line);
+	}
+    if (interactive && newLine)
+	Flush();
+}
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::EndLine
+// 	Move whatever is in the line buffer of a process to the ring.
+//----------------------------------------------------------------------
+
+void
+ConsoleBuffer::EndLine(ConsoleLine *line)
+{
+    if (line != NULL && line->used > 0) {
+	Append(line->data, line->used);
+	line->used = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::Flush
+// 	Write the ring to the host.  Anything the kernel printed goes
+//	out first, so it stays in order with the ring.
+//----------------------------------------------------------------------
+
+void
+ConsoleBuffer::Flush()
+{
+    fflush(stdout);
+    if (ringUsed == 0)
+	return;
+
+    int done = 0;
+    while (done < ringUsed) {
+	int count = write(1, ring + done, ringUsed - done);
+	if (count <= 0)
+	    break;			// nothing else we can do with it
+	done += count;
+    }
+    numFlushes++;
+    bytesWritten += ringUsed;
+    ringUsed = 0;
+}
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::Read
+// 	Copy "size" bytes of console input into "into", reading from the
+//	host a block at a time.  Pending output is written first, including
+//	the partial line of the reading process, which is likely a prompt.
+//
+//	Returns the number of bytes read, less than "size" only at the
+//	end of the input.
+//----------------------------------------------------------------------
+
+int
+ConsoleBuffer::Read(ConsoleLine *line, char *into, int size)
+{
+    int done = 0;
+
+    EndLine(line);
+    Flush();
+    while (done < size) {
+	if (inputStart == inputEnd) {
+	    if (inputDone)
+		break;
+	    int count = read(0, input, ConsoleInputSize);
+	    numHostReads++;
+	    if (count <= 0) {
+		inputDone = true;
+		break;
+	    }
+	    inputStart = 0;
+	    inputEnd = count;
+	}
+	int count = inputEnd - inputStart;
+	if (count > size - done)
+	    count = size - done;
+	memcpy(into + done, input + inputStart, count);
+	inputStart += count;
+	done += count;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// ConsoleBuffer::Print
+// 	Print the console statistics, at system shutdown.
+//----------------------------------------------------------------------
+
+void
+ConsoleBuffer::Print()
+{
+    if (numFlushes > 0 || numHostReads > 0)
+	printf("Console: %ld bytes in %d writes, %d reads\n",
+	    bytesWritten, numFlushes, numHostReads);
+}
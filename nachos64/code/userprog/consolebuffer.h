@@ -0,0 +1,76 @@
+// consolebuffer.h
+//	Data structures for the buffered console used by the Read and
+//	Write system calls on ConsoleInput and ConsoleOutput.
+//
+//	Output is collected in two levels.  Each process has a line
+//	buffer, so the lines written by different processes don't get
+//	mixed up; a line moves to the shared output ring when it is
+//	complete (or the line buffer is full).  The ring is written to the
+//	host when it is half full, so many Writes share one host write.
+//	It also goes out when the machine goes idle, before the console is
+//	read (so prompts are seen), when a process exits, when Nachos
+//	halts, and, if the host console is a terminal, at the end of each
+//	line, so a program that never stops running still shows its output.
+//
+//	Input is read ahead from the host in blocks of ConsoleInputSize
+//	bytes, instead of a character at a time.
+
+#ifndef CONSOLEBUFFER_H
+#define CONSOLEBUFFER_H
+
+#include "copyright.h"
+#include "utility.h"
+
+const int ConsoleLineSize = 128;	// bytes in a process line buffer
+const int ConsoleRingSize = 4096;	// bytes in the shared output ring
+const int ConsoleInputSize = 1024;	// bytes read ahead from the host
+
+// The following class defines the line buffer of one process.
+
+class ConsoleLine {
+  public:
+    ConsoleLine() { used = 0; }
+
+    char data[ConsoleLineSize];		// characters of the current line
+    int used;				// number of characters in "data"
+};
+
+// The following class defines the buffered console.
+
+class ConsoleBuffer {
+  public:
+    ConsoleBuffer();			// Initialize empty buffers
+    ~ConsoleBuffer();			// Write out what is still buffered
+
+    void Write(ConsoleLine *line, const char *from, int size);
+					// Write "size" bytes for the process
+					// with line buffer "line" (NULL to
+					// write straight to the ring)
+    void EndLine(ConsoleLine *line);	// Move a partial line to the ring,
+					// when the process exits
+    void Flush();			// Write the ring to the host
+
+    int Read(ConsoleLine *line, char *into, int size);
+					// Read "size" bytes for the process
+					// with line buffer "line", fewer only
+					// at the end of input
+
+    void Print();			// Print the console statistics
+
+  private:
+    char ring[ConsoleRingSize];		// output waiting to go to the host
+    int ringUsed;			// number of bytes in "ring"
+    bool interactive;			// the host output is a terminal
+    char input[ConsoleInputSize];	// input read ahead from the host
+    int inputStart;			// next byte of "input" to hand out
+    int inputEnd;			// end of the valid bytes in "input"
+    bool inputDone;			// the host input was exhausted
+
+    int numFlushes;			// host writes done
+    int numHostReads;			// host reads done
+    long bytesWritten;			// bytes written to the host
+
+    void Append(const char *from, int size);	// Add bytes to the ring
+};
+
+#endif // CONSOLEBUFFER_H
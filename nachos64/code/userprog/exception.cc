@@ -26,6 +26,9 @@
 #include "syscall.h"
 #include "synch.h"
 #include "noff.h"
+#include "asyncio.h"
+#include "futex.h"
+#include "pipe.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -78,6 +81,10 @@ void returnFromSystemCall() {
 
 void Nachos_Halt() {                    // System call 0
   DEBUG('a', "Shutdown, initiated by user program.\n");
+  if ( currentThread->process != NULL )
+  {
+    consoleBuffer->EndLine( &currentThread->process->consoleLine );
+  }
   interrupt->Halt();
 
 }// Nachos_Halt
@@ -121,67 +128,217 @@ void Nachos_Open() {                    // System call 5
   returnFromSystemCall();		// Update the PC registers
 }// Nachos_Open
 
-void Nachos_Read(){
-  //printf("Reading!\n");
-  int r4 =  machine->ReadRegister(4); // pointer to Nachos Mem
-  int size = machine->ReadRegister(5); // byte to read
-  OpenFileId fileId = machine->ReadRegister(6); // file to read
-  char bufferReader[size + 1] = {0}; // store unix result
+//----------------------------------------------------------------------
+// NachosRead, NachosWrite
+// 	Do the work of the Read and Write system calls, with the arguments
+//	given explicitly instead of in the user registers, so they can
+//	also be used by batched requests (see Nachos_SubmitBatch).
+//
+//	Data is moved IOChunkSize bytes at a time through a kernel buffer,
+//	so requests of any size can be served without a kernel stack buffer
+//	sized by the user.  Each request takes a buffer of its own from
+//	freeIOBuffers for the whole transfer, so a request that blocks
+//	(console input, a page fault) doesn't hold up the others; there are
+//	only as many buffers as requests ever in progress at once.
+//
+//	If "offset" is not -1, the transfer starts at that position of the
+//	file (PRead, PWrite) and the current position is left alone.
+//
+//	Return the number of bytes transferred, which is less than "size"
+//	on end of file or if the host call fails part way, or -1 on error.
+//----------------------------------------------------------------------
+
+const int IOChunkSize = 4 * PageSize;
+
+int NachosRead( int r4, int size, OpenFileId fileId, int offset = -1 );
+int NachosWrite( int r4, int size, OpenFileId id, int offset = -1 );
+
+static List<char*> freeIOBuffers;	// not in use by any request
+
+static char* TakeIOBuffer()
+{
+  IntStatus oldLevel = interrupt->SetLevel( IntOff );
+  char* buffer = freeIOBuffers.IsEmpty() ? NULL : freeIOBuffers.Remove();
+  interrupt->SetLevel( oldLevel );
+  return ( buffer != NULL ) ? buffer : new char[ IOChunkSize ];
+}
+
+static void ReturnIOBuffer( char* buffer )
+{
+  IntStatus oldLevel = interrupt->SetLevel( IntOff );
+  freeIOBuffers.Prepend( buffer );	// the most recent is still cached
+  interrupt->SetLevel( oldLevel );
+}
+
+int NachosRead( int r4, int size, OpenFileId fileId, int offset ){
   int readBytes = 0; // amount of read bytes
-  int count = 0;
-  char t = '\n';
+  int unixHandle;
 
+  if ( size < 0 || offset < -1 || ( offset != -1 && fileId <= ConsoleError ) )
+  {
+    return -1;
+  }
   // verify if file is one of standar output/input
   switch ( fileId ) {
     case ConsoleOutput:
     printf("%s\n", "Error, can not read from standard output");
-    break;
+    return -1;
     case ConsoleError:
     printf("%s\n", "Error, can not read from standard error");
-    break;
+    return -1;
     case ConsoleInput:
-
-    while (count < size )
+    unixHandle = -1;
+    break;
+    default:
+    if ( !currentThread->mytable->isOpened( fileId ) ) // if file is no longer opened
     {
-      t = getchar();
-      bufferReader[count] = t;
-      ++count;
+      printf("\t\tError: unable to read file\n");
+      return -1;
     }
-
-    readBytes = strlen( bufferReader );
-    stats->numConsoleCharsRead+=readBytes;
-    // write into Nachos mem
-    for (int index = 0; index < readBytes; ++  index )
+    if ( currentThread->mytable->getPipe( fileId ) != NULL )
     {
-      machine->SafeWriteMem(r4, 1, bufferReader[index] );
-      ++r4;
+      NachosPipe* pipe = currentThread->mytable->getPipe( fileId );
+      return ( offset == -1 ) ? pipe->Read( r4, size ) : -1;
     }
-    machine->WriteRegister(2, readBytes );
+    unixHandle = currentThread->mytable->getUnixHandle( fileId );
     break;
-    default:
-    if ( currentThread->mytable->isOpened( fileId ) ) // if file is still opened
+  }
+
+  ConsoleLine* line = ( currentThread->process != NULL )
+                      ? &currentThread->process->consoleLine : NULL;
+  char* ioBuffer = TakeIOBuffer();
+  while ( readBytes < size )
+  {
+    int chunk = size - readBytes;
+    int count = 0;
+    if ( chunk > IOChunkSize )
+    {
+      chunk = IOChunkSize;
+    }
+    if ( unixHandle == -1 ) // console, stop at end of input
+    {
+      count = consoleBuffer->Read( line, ioBuffer, chunk );
+      stats->numConsoleCharsRead += count;
+    }
+    else //  read using Unix system call
     {
-      //  read using Unix system call
-      readBytes =  read( currentThread->mytable->getUnixHandle(fileId),
-      (void *)bufferReader, size );
-      // write into Nachos mem
-      for (int index = 0; index < readBytes; ++  index )
+      if ( offset == -1 )
       {
-        machine->SafeWriteMem(r4, 1, bufferReader[index] );
-        ++r4;
+        count = read( unixHandle, (void *)ioBuffer, chunk );
+      }else
+      {
+        count = pread( unixHandle, (void *)ioBuffer, chunk, offset + readBytes );
+      }
+      if ( count < 0 )
+      {
+        readBytes = ( readBytes > 0 ) ? readBytes : -1;
+        break;
       }
-      // return amount of read readBytes
-      machine->WriteRegister(2, readBytes );
-    }else // otherwise no chars read
+    }
+    // write into Nachos mem
+    if ( !machine->SafeWriteBlock( r4 + readBytes, count, ioBuffer ) )
     {
-      printf("\t\tError: unable to read file\n");
-      machine->WriteRegister(2,-1);
+      readBytes = -1;	// bad user buffer
+      break;
+    }
+    readBytes += count;
+    if ( count < chunk ) // end of file
+    {
+      break;
     }
-    break;
   }
+  ReturnIOBuffer( ioBuffer );
+  return readBytes;
+}// NachosRead
+
+void Nachos_Read(){                     // System call 6
+  //printf("Reading!\n");
+  int r4 =  machine->ReadRegister(4); // pointer to Nachos Mem
+  int size = machine->ReadRegister(5); // byte to read
+  OpenFileId fileId = machine->ReadRegister(6); // file to read
+  machine->WriteRegister( 2, NachosRead( r4, size, fileId ) );
   returnFromSystemCall();
 }// Nachos_Read
 
+int NachosWrite( int r4, int size, OpenFileId id, int offset ) {
+int result = 0;
+int unixOpenFileId = -1;
+
+if ( size < 0 || offset < -1 || ( offset != -1 && id <= ConsoleError ) ) {
+  return -1;
+}
+// Console output is kept in the line buffer of the process, see consolebuffer.h
+ConsoleLine* line = ( currentThread->process != NULL )
+                    ? &currentThread->process->consoleLine : NULL;
+switch (id) {
+  case  ConsoleInput:	// User could not write to standard input
+  return -1;
+  case ConsoleError:	// This trick permits to write integers to console
+  {
+    char number[ 16 ];
+    int length = snprintf( number, sizeof(number), "%d\n", r4 );
+    Console->P();
+    consoleBuffer->Write( line, number, length );
+    stats->numConsoleCharsWritten += 1;
+    Console->V();
+  }
+  return size;
+  case  ConsoleOutput:
+  break;
+  default:	// All other opened files
+  // Verify if the file is opened, if not return -1
+  if(!currentThread->mytable->isOpened(id)){
+    return -1;
+  }
+  // Pipes do their own blocking, without the IO buffer
+  if ( currentThread->mytable->getPipe( id ) != NULL ) {
+    NachosPipe* pipe = currentThread->mytable->getPipe( id );
+    return ( offset == -1 ) ? pipe->Write( r4, size ) : -1;
+  }
+  // Get the unix handle from our table for open files
+  unixOpenFileId = currentThread->mytable->getUnixHandle(id);
+  break;
+}
+
+char* ioBuffer = TakeIOBuffer();
+while ( result < size ) {
+  int chunk = size - result;
+  int count;
+  if ( chunk > IOChunkSize ) {
+    chunk = IOChunkSize;
+  }
+  if ( !machine->SafeReadBlock( r4 + result, chunk, ioBuffer ) ) {
+    result = -1;	// bad user buffer
+    break;
+  }
+  if ( unixOpenFileId == -1 ) {	// console output stops at the first null
+    count = strnlen( ioBuffer, chunk );
+    // Need a semaphore to synchronize access to console
+    Console->P();
+    consoleBuffer->Write( line, ioBuffer, count );
+    Console->V();
+    // Update simulation stats, see details in Statistics class in machine/stats.cc
+    stats->numConsoleCharsWritten += count;
+  } else {	// Do the write to the already opened Unix file
+    if ( offset == -1 ) {
+      count = write( unixOpenFileId, ioBuffer, chunk );
+    } else {
+      count = pwrite( unixOpenFileId, ioBuffer, chunk, offset + result );
+    }
+    if ( count < 0 ) {
+      result = ( result > 0 ) ? result : -1;
+      break;
+    }
+  }
+  result += count;
+  if ( count < chunk ) {	// partial write
+    break;
+  }
+}
+ReturnIOBuffer( ioBuffer );
+return result;
+}// NachosWrite
+
 void Nachos_Write() {                   // System call 7
 
   /* System call definition described to user
@@ -193,56 +350,55 @@ void Nachos_Write() {                   // System call 7
 */
 int r4 = machine->ReadRegister( 4 );
 int size = machine->ReadRegister( 5 );	// Read size to write
-char buffer[size+1] = {0};
-int c = '*', i = 0;
-do{
-  machine->SafeReadMem(r4, 1, &c);
-  r4++;
-  buffer[i++] = c;
-}while(i < size);
+OpenFileId id = machine->ReadRegister( 6 );	// Read file descriptor
+machine->WriteRegister( 2, NachosWrite( r4, size, id ) );
+returnFromSystemCall();		// Update the PC registers
 
-//printf("Texto para escribrir en archivo: <<%s>>\n", buffer);
+}// Nachos_Write
 
-// buffer = Read data from address given by user;
-OpenFileId id = machine->ReadRegister( 6 );	// Read file descriptor
+void Nachos_Seek() {
+  /* Move the current position of the file
+  int Seek(OpenFileId id, int offset, int whence);
+  */
+  OpenFileId id = machine->ReadRegister( 4 );
+  int offset = machine->ReadRegister( 5 );
+  int whence = machine->ReadRegister( 6 );
+  int result = -1;
 
-// Need a semaphore to synchronize access to console
-Console->P();
-switch (id) {
-  case  ConsoleInput:	// User could not write to standard input
-  machine->WriteRegister( 2, -1 );
-  size = 0;
-  break;
-  case  ConsoleOutput:
-  printf( "%s", buffer );
-  stats->numConsoleCharsWritten+= strlen(buffer);
-  break;
-  case ConsoleError:	// This trick permits to write integers to console
-  printf( "%d\n", machine->ReadRegister( 4 ) );
-  size = 1;
-  break;
-  default:	// All other opened files
-  // Verify if the file is opened, if not return -1 in r2
-  if(!currentThread->mytable->isOpened(id)){
-    machine->WriteRegister( 2, -1 );
-    size = 0;
-    return;
+  if ( id > ConsoleError && currentThread->mytable->isOpened( id ) )
+  {
+    int unixWhence = ( whence == SeekCur ) ? SEEK_CUR
+                   : ( whence == SeekEnd ) ? SEEK_END : SEEK_SET;
+    if ( whence >= SeekSet && whence <= SeekEnd )
+    {
+      result = lseek( currentThread->mytable->getUnixHandle( id ),
+                      offset, unixWhence );
+    }
   }
-  // Get the unix handle from our table for open files
-  int unixOpenFileId = currentThread->mytable->getUnixHandle(id);
-  // Do the write to the already opened Unix file
-  int charCounter = write(unixOpenFileId, buffer, size);
-  // Return the number of chars written to user, via r2
-  machine->WriteRegister( 2, charCounter );
-  break;
+  machine->WriteRegister( 2, result );
+}// Nachos_Seek
 
-}
-// Update simulation stats, see details in Statistics class in machine/stats.cc
-stats->numConsoleCharsWritten += size;
-Console->V();
-returnFromSystemCall();		// Update the PC registers
-
-}// Nachos_Write
+void Nachos_PRead() {
+  /* Read "size" bytes at position "offset", without moving the position
+  int PRead(char *buffer, int size, OpenFileId id, int offset);
+  */
+  int r4 = machine->ReadRegister( 4 );
+  int size = machine->ReadRegister( 5 );
+  OpenFileId id = machine->ReadRegister( 6 );
+  int offset = machine->ReadRegister( 7 );
+  machine->WriteRegister( 2, ( offset < 0 ) ? -1 : NachosRead( r4, size, id, offset ) );
+}// Nachos_PRead
+
+void Nachos_PWrite() {
+  /* Write "size" bytes at position "offset", without moving the position
+  int PWrite(char *buffer, int size, OpenFileId id, int offset);
+  */
+  int r4 = machine->ReadRegister( 4 );
+  int size = machine->ReadRegister( 5 );
+  OpenFileId id = machine->ReadRegister( 6 );
+  int offset = machine->ReadRegister( 7 );
+  machine->WriteRegister( 2, ( offset < 0 ) ? -1 : NachosWrite( r4, size, id, offset ) );
+}// Nachos_PWrite
 
 void Nachos_Create(){
   ///printf("Creating!\n");
@@ -283,9 +439,10 @@ void Nachos_Close(){
   void Close(OpenFileId id);*/
   //printf("Closing!\n");
   OpenFileId id = machine->ReadRegister( 4 );
+  bool isPipe = currentThread->mytable->getPipe( id ) != NULL;
   int unixOpenFileId = currentThread->mytable->getUnixHandle( id );
   int nachosResult = currentThread->mytable->Close(id);
-  int unixResult = close( unixOpenFileId );
+  int unixResult = isPipe ? 0 : close( unixOpenFileId );
   if(nachosResult == -1 || unixResult == -1 ){
     printf("Error: unable to close file\n");
   }
@@ -293,6 +450,26 @@ void Nachos_Close(){
   returnFromSystemCall();		// Update the PC registers
 }// Nachos_Close
 
+void Nachos_Pipe(){
+  /* Make a pipe, store its read and write ends in ends[0] and ends[1]
+  int Pipe(OpenFileId *ends);
+  */
+  int r4 = machine->ReadRegister( 4 );
+  NachosPipe* pipe = new NachosPipe();
+  int readEnd = currentThread->mytable->OpenPipe( pipe, PipeReadEnd );
+  int writeEnd = currentThread->mytable->OpenPipe( pipe, PipeWriteEnd );
+  if ( !machine->SafeWriteMem( r4, 4, readEnd )
+       || !machine->SafeWriteMem( r4 + 4, 4, writeEnd ) )
+  {
+    currentThread->mytable->Close( readEnd );	// the last one frees it
+    currentThread->mytable->Close( writeEnd );
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+  DEBUG( 'u', "Pipe %d -> %d\n", writeEnd, readEnd );
+  machine->WriteRegister( 2, 0 );
+}// Nachos_Pipe
+
 void NachosForkThread( void * p ) { // for 64 bits version
   AddrSpace *space;
   long dir = (long) p;
@@ -340,6 +517,11 @@ void Nachos_Fork()
   // This new constructor will copy the shared segments (space variable) from currentThread, passed
   // as a parameter, and create a new stack for the new child
   newT->space = new AddrSpace( currentThread->space );
+  newT->process = currentThread->process;	// same process
+  if ( newT->process != NULL )
+  {
+    processTable->AddThread( newT->process );
+  }
 
   // We (kernel)-Fork to a new method to execute the child code
   // Pass the user routine address, now in register 4, as a parameter
@@ -390,11 +572,8 @@ void Nachos_SemWait()
   }
 }// Nachos_SemWait
 
-void Nachos_SemSignal()
+int NachosSemSignal( int semId )
 {
-  //printf("%s\n", "Nachos signal");
-  int semId = machine->ReadRegister( 4 );
-  //printf("id: %d\n", semId );
   long pointerToCast = currentThread->mySems->getNachosPointer( semId );
   //printf("Valor direccion %ld\n",pointerToCast);
   if ( pointerToCast != -1 )
@@ -403,12 +582,18 @@ void Nachos_SemSignal()
     //printf("%s%d\n","Hago signal valor semaforo: ", sem->getValue() );
     sem->V(); // then wait
     //printf("%s%d\n","Hago signal valor semaforo: ", sem->getValue() );
-    machine->WriteRegister( 2, 0 );
-  }else
-  {
-    printf("%s\n","No Hago signal" );
-    machine->WriteRegister( 2, -1 );
+    return 0;
   }
+  printf("%s\n","No Hago signal" );
+  return -1;
+}// NachosSemSignal
+
+void Nachos_SemSignal()
+{
+  //printf("%s\n", "Nachos signal");
+  int semId = machine->ReadRegister( 4 );
+  //printf("id: %d\n", semId );
+  machine->WriteRegister( 2, NachosSemSignal( semId ) );
 }// Nachos_SemSignal
 
 void Nachos_SemDestroy()
@@ -429,71 +614,440 @@ void Nachos_SemDestroy()
   }
 }// Nachos_SemDestroy
 
-struct joinS
+//----------------------------------------------------------------------
+// Nachos_FutexWait, Nachos_FutexWake
+// 	The slow path of the user semaphores in start.s.  The counter is
+//	in user memory; the kernel only keeps the threads sleeping on it,
+//	in futexes, keyed by the user address and the semaphore table,
+//	that all the threads of a process share.
+//----------------------------------------------------------------------
+
+void Nachos_FutexWait()
 {
-  long threadId;
-  std::string fileName;
-  Semaphore* s;
-  inline joinS():threadId(-1),fileName(),s(NULL){}
-};
+  /* Sleep while *addr == expected
+  int FutexWait(int *addr, int expected);
+  */
+  int addr = machine->ReadRegister( 4 );
+  int expected = machine->ReadRegister( 5 );
+  if ( addr & 0x3 )
+  {
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+  machine->WriteRegister( 2, futexes->Wait( currentThread->mySems, addr, expected ) );
+}// Nachos_FutexWait
+
+void Nachos_FutexWake()
+{
+  /* Wake up to "count" threads sleeping on addr
+  int FutexWake(int *addr, int count);
+  */
+  int addr = machine->ReadRegister( 4 );
+  int count = machine->ReadRegister( 5 );
+  machine->WriteRegister( 2, futexes->Wake( currentThread->mySems, addr, count ) );
+}// Nachos_FutexWake
+
+void Nachos_Mmap()
+{
+  /* Map the first "length" bytes of the file "name"
+  int Mmap(char *name, int length);
+  */
+  DEBUG( 'v', "Entering MMAP System call\n" );
+#ifdef VM
+  int r4 = machine->ReadRegister( 4 ); // file name in Nachos mem
+  int length = machine->ReadRegister( 5 ); // bytes to map
+  char fileName[256] = {0};
+  int c, i = 0;
+  do
+  {
+    machine->SafeReadMem( r4, 1, &c );
+    r4++;
+    fileName[i++] = c;
+  }while ( c != 0 && i < 255 );
+
+  OpenFile* file = fileSystem->Open( fileName );
+  if ( file == NULL )
+  {
+    printf("\t\tError: unable to map file <<%s>>\n", fileName );
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+  int addr = currentThread->space->mapFile( file, length );
+  if ( addr == -1 )
+  {
+    delete file;
+  }
+  machine->WriteRegister( 2, addr );
+#else
+  // without demand paging there is no fault to fill the pages
+  machine->WriteRegister( 2, -1 );
+#endif
+}// Nachos_Mmap
+
+void Nachos_Munmap()
+{
+  /* Unmap the mapping that starts at "addr"
+  int Munmap(int addr);
+  */
+#ifdef VM
+  int addr = machine->ReadRegister( 4 );
+  machine->WriteRegister( 2, currentThread->space->unmapFile( addr ) );
+#else
+  machine->WriteRegister( 2, -1 );
+#endif
+}// Nachos_Munmap
+
+void Nachos_ShmCreate()
+{
+  /* Make a shared memory segment of "size" bytes, return its id
+  int ShmCreate(int size);
+  */
+#ifdef VM
+  int size = machine->ReadRegister( 4 );
+  machine->WriteRegister( 2, sharedMemory->Create( size ) );
+#else
+  machine->WriteRegister( 2, -1 );
+#endif
+}// Nachos_ShmCreate
+
+void Nachos_ShmAttach()
+{
+  /* Map segment "id" at "addr" (0: anywhere), return its address
+  int ShmAttach(int id, int addr);
+  */
+#ifdef VM
+  int id = machine->ReadRegister( 4 );
+  int addr = machine->ReadRegister( 5 );
+  SharedSegment* segment = sharedMemory->Get( id );
+  machine->WriteRegister( 2, ( segment == NULL ) ? -1
+                          : currentThread->space->attachSegment( segment, addr ) );
+#else
+  machine->WriteRegister( 2, -1 );
+#endif
+}// Nachos_ShmAttach
+
+void Nachos_ShmDetach()
+{
+  /* Unmap the segment attached at "addr"
+  int ShmDetach(int addr);
+  */
+#ifdef VM
+  int addr = machine->ReadRegister( 4 );
+  machine->WriteRegister( 2, currentThread->space->detachSegment( addr ) );
+#else
+  machine->WriteRegister( 2, -1 );
+#endif
+}// Nachos_ShmDetach
+
+void Nachos_SetPriority()
+{
+  /* Change the scheduling priority of the calling thread
+  int SetPriority(int priority);
+  */
+  int priority = machine->ReadRegister( 4 );
+  // A thread may only make itself less urgent, or it could starve
+  // every other process by taking level 0
+  if ( priority < currentThread->getPriority() || priority > MaxPriority )
+  {
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+  machine->WriteRegister( 2, currentThread->getPriority() );
+  currentThread->setPriority( priority );
+}// Nachos_SetPriority
+
+void Nachos_GetPriority()
+{
+  /* Return the scheduling priority of the calling thread
+  int GetPriority();
+  */
+  machine->WriteRegister( 2, currentThread->getPriority() );
+}// Nachos_GetPriority
+
+void Nachos_Sleep()
+{
+  /* Block the calling thread for a number of ticks
+  int Sleep( int ticks );
+  */
+  int ticks = machine->ReadRegister( 4 );
+  if ( ticks > 0 )
+  {
+    alarmClock->WaitUntil( stats->totalTicks + ticks );
+  }
+  machine->WriteRegister( 2, 0 );
+}// Nachos_Sleep
+
+void Nachos_Yield()
+{
+  currentThread->Yield();
+}// Nachos_Yield
+
+//----------------------------------------------------------------------
+// NachosThreadDone
+// 	The current thread, one of the threads of its process, is done.
+//	The last one frees the asynchronous requests the process never
+//	waited for, and lets the process table reap the process.  Must be
+//	called with interrupts off.
+//----------------------------------------------------------------------
+
+static void NachosThreadDone()
+{
+  Process* process = currentThread->process;
+  if ( process == NULL )
+  {
+    return;
+  }
+  if ( process->numThreads == 1 )
+  {
+    asyncRequests->Release( process );
+  }
+  processTable->ThreadExit( process );
+  currentThread->process = NULL;
+}// NachosThreadDone
+
+//----------------------------------------------------------------------
+// Nachos_ReadAsync, Nachos_WriteAsync, Nachos_WaitIO
+// 	Asynchronous I/O.  The request is registered in asyncRequests and
+//	handed to a new kernel thread, NachosIOWorker, that shares the
+//	address space, open files and semaphores of the caller, so the
+//	caller can keep running while the transfer is done.  The worker is
+//	a thread of the caller's process until it is done, so the process
+//	and everything it shares outlive the transfer.
+//----------------------------------------------------------------------
+
+void NachosIOWorker( void* p )
+{
+  long id = (long) p;
+  AsyncIORequest* request = asyncRequests->Get( id );
+  int result;
+
+  if ( request->op == SC_Read )
+  {
+    result = NachosRead( request->buffer, request->size, request->fileId );
+  }else
+  {
+    result = NachosWrite( request->buffer, request->size, request->fileId );
+  }
+  DEBUG( 'u', "Async IO request %ld done, result %d\n", id, result );
+  if ( request->semId != -1 )
+  {
+    NachosSemSignal( request->semId );
+  }
+  asyncRequests->Complete( id, result );
+
+  if ( currentThread->mytable->delThread() )	// the process is gone
+  {
+    currentThread->mytable->CloseAll();
+  }
+  currentThread->mytable = NULL;
+  IntStatus oldLevel = interrupt->SetLevel( IntOff );
+  NachosThreadDone();
+  interrupt->SetLevel( oldLevel );
+}// NachosIOWorker
+
+static void NachosStartAsync( int op )
+{
+  int r4 = machine->ReadRegister( 4 );	// buffer
+  int size = machine->ReadRegister( 5 );
+  OpenFileId fileId = machine->ReadRegister( 6 );
+  int semId = machine->ReadRegister( 7 );	// semaphore to signal, or -1
+
+  long id = asyncRequests->Submit( op, r4, size, fileId, semId,
+                                   currentThread->process );
+  if ( id == -1 )
+  {
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+
+  Thread* worker = new Thread( "IO worker" );
+  // The worker uses the caller's files, semaphores and memory
+  delete worker->mytable;
+  worker->mytable = currentThread->mytable;
+  worker->mytable->addThread();
+  delete worker->mySems;
+  worker->mySems = currentThread->mySems;
+  worker->mySems->addSem();
+  worker->space = currentThread->space;
+  worker->process = currentThread->process;
+  if ( worker->process != NULL )
+  {
+    processTable->AddThread( worker->process );
+  }
+
+  worker->Fork( NachosIOWorker, (void*) id );
+  machine->WriteRegister( 2, id );
+}// NachosStartAsync
+
+void Nachos_ReadAsync()
+{
+  /* Start reading "size" bytes into "buffer", return a request id
+  int ReadAsync(char *buffer, int size, OpenFileId id, int semId);
+  */
+  NachosStartAsync( SC_Read );
+}// Nachos_ReadAsync
+
+void Nachos_WriteAsync()
+{
+  /* Start writing "size" bytes from "buffer", return a request id
+  int WriteAsync(char *buffer, int size, OpenFileId id, int semId);
+  */
+  NachosStartAsync( SC_Write );
+}// Nachos_WriteAsync
+
+void Nachos_WaitIO()
+{
+  /* Wait for an asynchronous request, return its result
+  int WaitIO(int requestId);
+  */
+  int id = machine->ReadRegister( 4 );
+  machine->WriteRegister( 2, asyncRequests->Wait( id, currentThread->process ) );
+}// Nachos_WaitIO
+
+static void CountBatchedSyscall( int type );
+
+//----------------------------------------------------------------------
+// BatchMayBlock
+// 	Return true if a Read or Write of "id" could block: console input
+//	waits for the user to type, and a pipe end waits for the other end.
+//	A batch runs without giving up the CPU, so those requests are not
+//	run and complete with -1.
+//----------------------------------------------------------------------
 
-joinS** execFiles = new joinS*[128];
-BitMap* execFilesMap = new BitMap(128);
+static bool BatchMayBlock( OpenFileId id )
+{
+  if ( id == ConsoleInput )
+  {
+    return true;
+  }
+  return id > ConsoleError && currentThread->mytable->isOpened( id )
+         && currentThread->mytable->getPipe( id ) != NULL;
+}
+
+void Nachos_SubmitBatch()
+{
+  /* Run every request queued in the ring, and return how many were run
+  int SubmitBatch(SyscallRing *ring);
+  */
+  int ring = machine->ReadRegister( 4 );
+  int head, tail, size;
+  int done = 0;
+
+  if ( ring & 0x3 )	// the ring is read a word at a time
+  {
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+  if ( !machine->SafeReadMem( ring + SyscallRingHead, 4, &head )
+       || !machine->SafeReadMem( ring + SyscallRingTail, 4, &tail )
+       || !machine->SafeReadMem( ring + SyscallRingSizeOffset, 4, &size ) )
+  {
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+  // head and tail come from the user: at most "size" requests can be queued
+  long long pending = (long long) head - tail;
+  if ( size <= 0 || size > SyscallRingSize || pending < 0 || pending > size )
+  {
+    machine->WriteRegister( 2, -1 );
+    return;
+  }
+
+  while ( done < pending )
+  {
+    int entry = ring + SyscallRingEntries
+                + ( ( tail % size ) + size ) % size * SyscallRequestSize;
+    int op, arg1, arg2, arg3, result;
+    if ( !machine->SafeReadMem( entry, 4, &op )
+         || !machine->SafeReadMem( entry + 4, 4, &arg1 )
+         || !machine->SafeReadMem( entry + 8, 4, &arg2 )
+         || !machine->SafeReadMem( entry + 12, 4, &arg3 ) )
+    {
+      machine->WriteRegister( 2, -1 );
+      return;
+    }
+
+    switch ( op )
+    {
+      case SC_Read:
+      result = BatchMayBlock( arg3 ) ? -1 : NachosRead( arg1, arg2, arg3 );
+      break;
+      case SC_Write:
+      result = BatchMayBlock( arg3 ) ? -1 : NachosWrite( arg1, arg2, arg3 );
+      break;
+      case SC_SemSignal:
+      result = NachosSemSignal( arg1 );
+      break;
+      default:
+      result = -1;
+      break;
+    }
+    CountBatchedSyscall( op );
+    machine->SafeWriteMem( entry + 16, 4, result );	// completion
+    ++tail;
+    ++done;
+    machine->SafeWriteMem( ring + SyscallRingTail, 4, tail );
+  }
+  machine->WriteRegister( 2, done );
+}// Nachos_SubmitBatch
 
 void Nachos_Exit(){
   /* This user program is done (status = 0 means exited normally). */
   //void Exit(int status);
   int exitValue = machine->ReadRegister(4);
+  if ( currentThread->process != NULL )	// show what it wrote so far
+  {
+    consoleBuffer->EndLine( &currentThread->process->consoleLine );
+  }
+  consoleBuffer->Flush();
   printf("Exit with value: %d\n", exitValue  );
-  Thread* nextThread;
+#ifdef VM
+  currentThread->space->unmapAll();	// write back mapped files
+#endif
+  accounting->Close( currentThread->space->account );	// spaces are
+					// never deleted, it's done with it
+  currentThread->space->account = NULL;
+  // The last thread using the files closes them, so the other end of
+  // its pipes sees end of file
+  if ( currentThread->mytable->delThread() )
+  {
+    currentThread->mytable->CloseAll();
+  }
+  currentThread->mytable = NULL;
   IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-  DEBUG('t', "Finishing thread \"%s\"\n", currentThread->getName());
-
-  //printf("currentThread: %ld\n", (long)currentThread);
-
-  for(int ind = 0; ind < 128; ++ind){
-    if(execFilesMap->Test(ind)){
-      //printf("I'm a EXEC thread %ld\n", execFiles[ind]->threadId);
-      if((long)currentThread == execFiles[ind]->threadId){
-        if(execFiles[ind]->s != NULL){
-          //printf("Someone is wainting for me: %ld\n", execFiles[ind]->threadId);
-          execFiles[ind]->s->V();
-        }
-        else{
-          //printf("No one is wainting for me: %ld\n", execFiles[ind]->threadId);
-          delete execFiles[ind];
-          execFilesMap->Clear(ind);
-        }
-      }
-    }
+  // Only the thread that Exec started ends the process, not its Forks
+  Process* process = currentThread->process;
+  if ( process != NULL && process->thread == currentThread )
+  {
+    processTable->Exit( process, exitValue );
   }
+  NachosThreadDone();	// the last thread out reaps it
 
   machine->WriteRegister(2, machine->ReadRegister(4));
 
-  nextThread = scheduler->FindNextToRun();
-  if (nextThread != NULL) {
-    scheduler->Run(nextThread);
-  }else
-  {
-    currentThread->Finish();
-  }
+  // The next thread to run destroys this one, and recycles its stack
+  currentThread->Finish();
   interrupt->SetLevel(oldLevel);
   //returnFromSystemCall();
 }//Nachos_Exit
 
-void NachosExecThread( void* id)
+void NachosExecThread( void* p )
 {
-  joinS* info = execFiles[(long)id];
+  Process* process = (Process*) p;
 
-  OpenFile *executable = fileSystem->Open(info->fileName.c_str());
+  OpenFile *executable = fileSystem->Open(process->fileName.c_str());
   AddrSpace *space;
 
   if (executable == NULL) {
-    printf("Unable to open executable file <<%s>>\n",info->fileName.c_str());
+    printf("Unable to open executable file <<%s>>\n",process->fileName.c_str());
+    IntStatus oldLevel = interrupt->SetLevel( IntOff );
+    processTable->Exit( process, -1 );	// wake up Join
+    NachosThreadDone();
+    interrupt->SetLevel( oldLevel );
     return;
   }
-  space = new AddrSpace( executable, info->fileName.c_str() );
+  space = new AddrSpace( executable, process->fileName );
   delete currentThread->space; // i dont need may space anymore
   currentThread->space = space;
 
@@ -523,23 +1077,14 @@ void Nachos_Exec(){
     name[i++] = c;
   }while (c != 0 );
 
-  std::string s = name;
-  joinS* newE = new joinS();
-
   // We need to create a new kernel thread to execute the user thread
   Thread * newT = new Thread( "HILO EXEC" );
-  long fileToExec = execFilesMap->Find();
-  if(fileToExec == -1){
-    machine->WriteRegister(2, fileToExec );
-    return;
-  }
-
-  newE->threadId = (long) newT;
-  newE->fileName = s;
-  execFiles[fileToExec] = newE;
+  Process* process = processTable->Create( newT, currentThread->process, name );
+  newT->process = process;
+  newT->mytable->Inherit( currentThread->mytable );	// pipes and files
 
-  newT->Fork( NachosExecThread, (void*) fileToExec ); // ojo se elimino warning
-  machine->WriteRegister(2, fileToExec );
+  newT->Fork( NachosExecThread, (void*) process );
+  machine->WriteRegister(2, process->id );
   returnFromSystemCall();	// This adjust the PrevPC, PC, and NextPC registers
 
   DEBUG( 't', "Exiting EXEC System call\n" );
@@ -554,25 +1099,129 @@ void Nachos_Join()
   DEBUG( 't', "Entering JOIN System call\n" );
 
   //First I need to read the SpaceID of the thread I must wait for
-  long id = machine->ReadRegister( 4 ); // read from register 4
-  //I need to make sure it is a valid thread
-  if(execFilesMap->Test(id)){
-    //I need to create a Semaphore asosieted with this SpaceID
-    Semaphore* joinSem = new Semaphore("JOIN Semaphore", 0);
-    execFiles[id]->s = joinSem;
-    joinSem->P();
-    //printf("%ld: %s\n", execFiles[id]->threadId, "just give me a sigh");
-    delete execFiles[id];
-    execFilesMap->Clear(id);
-    machine->WriteRegister(2, 0);
-  }
-  else{ //invalid SpaceID
-    //printf("%s\n", "Error JOIN: ¡Invalid SpaceID!");
-    machine->WriteRegister(2, -1 );
-  }
+  int id = machine->ReadRegister( 4 ); // read from register 4
+  // -1 if it isn't one of our children, or it was already joined
+  machine->WriteRegister( 2, processTable->Join( currentThread->process, id ) );
   returnFromSystemCall();	// This adjust the PrevPC, PC, and NextPC registers
 }// Nachos_Join
 
+//----------------------------------------------------------------------
+// syscallTable
+// 	One entry per system call, indexed by its SC_* code.  "advancePC"
+//	is true for handlers that leave updating the PC to the dispatcher;
+//	the others do it themselves (or never return, like Exit).
+//	"count" and "batched" are the number of calls made by trapping
+//	and through SubmitBatch.
+//----------------------------------------------------------------------
+
+struct SyscallEntry
+{
+  int code;
+  const char* name;
+  VoidNoArgFunctionPtr handler;
+  bool advancePC;
+  int count;
+  int batched;
+};
+
+static SyscallEntry syscallTable[] = {
+  { SC_Halt,		"Halt",		Nachos_Halt,		false, 0, 0 },
+  { SC_Exit,		"Exit",		Nachos_Exit,		false, 0, 0 },
+  { SC_Exec,		"Exec",		Nachos_Exec,		false, 0, 0 },
+  { SC_Join,		"Join",		Nachos_Join,		false, 0, 0 },
+  { SC_Create,		"Create",	Nachos_Create,		false, 0, 0 },
+  { SC_Open,		"Open",		Nachos_Open,		false, 0, 0 },
+  { SC_Read,		"Read",		Nachos_Read,		false, 0, 0 },
+  { SC_Write,		"Write",	Nachos_Write,		false, 0, 0 },
+  { SC_Close,		"Close",	Nachos_Close,		false, 0, 0 },
+  { SC_Fork,		"Fork",		Nachos_Fork,		false, 0, 0 },
+  { SC_Yield,		"Yield",	Nachos_Yield,		true,  0, 0 },
+  { SC_SemCreate,	"SemCreate",	Nachos_SemCreate,	true,  0, 0 },
+  { SC_SemDestroy,	"SemDestroy",	Nachos_SemDestroy,	true,  0, 0 },
+  { SC_SemSignal,	"SemSignal",	Nachos_SemSignal,	true,  0, 0 },
+  { SC_SemWait,		"SemWait",	Nachos_SemWait,		true,  0, 0 },
+  { SC_Mmap,		"Mmap",		Nachos_Mmap,		true,  0, 0 },
+  { SC_Munmap,		"Munmap",	Nachos_Munmap,		true,  0, 0 },
+  { SC_SubmitBatch,	"SubmitBatch",	Nachos_SubmitBatch,	true,  0, 0 },
+  { SC_ReadAsync,	"ReadAsync",	Nachos_ReadAsync,	true,  0, 0 },
+  { SC_WriteAsync,	"WriteAsync",	Nachos_WriteAsync,	true,  0, 0 },
+  { SC_WaitIO,		"WaitIO",	Nachos_WaitIO,		true,  0, 0 },
+  { SC_Seek,		"Seek",		Nachos_Seek,		true,  0, 0 },
+  { SC_PRead,		"PRead",	Nachos_PRead,		true,  0, 0 },
+  { SC_PWrite,		"PWrite",	Nachos_PWrite,		true,  0, 0 },
+  { SC_FutexWait,	"FutexWait",	Nachos_FutexWait,	true,  0, 0 },
+  { SC_FutexWake,	"FutexWake",	Nachos_FutexWake,	true,  0, 0 },
+  { SC_Pipe,		"Pipe",		Nachos_Pipe,		true,  0, 0 },
+  { SC_ShmCreate,	"ShmCreate",	Nachos_ShmCreate,	true,  0, 0 },
+  { SC_ShmAttach,	"ShmAttach",	Nachos_ShmAttach,	true,  0, 0 },
+  { SC_ShmDetach,	"ShmDetach",	Nachos_ShmDetach,	true,  0, 0 },
+  { SC_SetPriority,	"SetPriority",	Nachos_SetPriority,	true,  0, 0 },
+  { SC_GetPriority,	"GetPriority",	Nachos_GetPriority,	true,  0, 0 },
+  { SC_Sleep,		"Sleep",	Nachos_Sleep,		true,  0, 0 },
+};
+
+static const int NumSyscalls = sizeof(syscallTable) / sizeof(SyscallEntry);
+
+//----------------------------------------------------------------------
+// DispatchSyscall
+// 	Call the handler registered for system call "type".
+//----------------------------------------------------------------------
+
+static void DispatchSyscall( int type )
+{
+  if ( type < 0 || type >= NumSyscalls )
+  {
+    printf("Unexpected syscall exception %d\n", type );
+    ASSERT(false);
+  }
+  SyscallEntry* entry = &syscallTable[ type ];
+  ASSERT( entry->code == type );	// the table must be in SC_* order
+  entry->count++;
+  accounting->CountSyscall();
+  (*entry->handler)();
+  if ( entry->advancePC )
+  {
+    returnFromSystemCall();
+  }
+}// DispatchSyscall
+
+static void CountBatchedSyscall( int type )
+{
+  if ( type >= 0 && type < NumSyscalls )
+  {
+    syscallTable[ type ].batched++;
+  }
+}// CountBatchedSyscall
+
+//----------------------------------------------------------------------
+// PrintSyscallStats
+// 	Print how many times each system call was made, at halt.
+//----------------------------------------------------------------------
+
+void PrintSyscallStats()
+{
+  bool any = false;
+  for ( int index = 0; index < NumSyscalls; ++index )
+  {
+    SyscallEntry* entry = &syscallTable[ index ];
+    if ( entry->count == 0 && entry->batched == 0 )
+    {
+      continue;
+    }
+    printf( "%s%s %d", any ? ", " : "Syscalls: ", entry->name, entry->count );
+    if ( entry->batched > 0 )
+    {
+      printf( " (+%d batched)", entry->batched );
+    }
+    any = true;
+  }
+  if ( any )
+  {
+    printf( "\n" );
+  }
+  futexes->Print();
+}// PrintSyscallStats
+
 void ExceptionHandler(ExceptionType which)
 {
   int type = machine->ReadRegister(2);
@@ -581,63 +1230,7 @@ void ExceptionHandler(ExceptionType which)
   switch ( which ) {
 
     case SyscallException:
-    switch ( type )
-    {
-      case SC_Halt:                 //System call # 0
-      Nachos_Halt();
-      break;
-      case SC_Exit:                 //System call # 1
-      Nachos_Exit();
-      break;
-      case SC_Exec:                 //System call # 2
-      Nachos_Exec();
-      break;
-      case SC_Join:                 //System call # 3
-      Nachos_Join();
-      break;
-      case SC_Create:               //System call # 4
-      Nachos_Create();
-      break;
-      case SC_Open:                 //System call # 5
-      Nachos_Open();
-      break;
-      case SC_Read:                 //System call # 6
-      Nachos_Read();
-      break;
-      case SC_Write:                //System call # 7
-      Nachos_Write();
-      break;
-      case SC_Close:                //System call # 8
-      Nachos_Close();
-      break;
-      case SC_Fork:                 //System call # 9
-      Nachos_Fork();
-      break;
-      case SC_Yield:                //System call # 10
-      currentThread->Yield();
-      returnFromSystemCall();
-      break;
-      case SC_SemCreate:            //System call # 11
-      Nachos_SemCreate();
-      returnFromSystemCall();
-      break;
-      case SC_SemDestroy:           //System call # 12
-      Nachos_SemDestroy();
-      returnFromSystemCall();
-      break;
-      case SC_SemSignal:            //System call # 13
-      Nachos_SemSignal();
-      returnFromSystemCall();
-      break;
-      case SC_SemWait:              //System call # 14
-      Nachos_SemWait();
-      returnFromSystemCall();
-      break;
-      default:
-      printf("Unexpected syscall exception %d\n", type );
-      ASSERT(false);
-      break;
-    }
+    DispatchSyscall( type );
     break;
     case PageFaultException:
         DEBUG('v', "\nPageFaultException\n");
@@ -645,7 +1238,16 @@ void ExceptionHandler(ExceptionType which)
         DEBUG('v', "Direccion logica: %d\n", vpn);
         vpn /= PageSize;
         DEBUG('v', "Pagina que falla: %d\n", vpn);
+        accounting->CountFault();
+#ifdef VM
+        if ( faultStats != NULL ) faultStats->Begin();
+#endif
         currentThread->space->load(vpn);
+#ifdef VM
+        if ( faultStats != NULL )
+          faultStats->End( &currentThread->space->faultRecord,
+                           currentThread->space->filename.c_str(), vpn );
+#endif
     break;
     case ReadOnlyException:
     printf("\nReadOnlyException\n");
@@ -0,0 +1,366 @@
+// execcache.cc
+//	Routines to keep the images of recently launched programs, so
+//	that they don't have to be read from the program file again.
+
+#include "copyright.h"
+#include "execcache.h"
+#include "system.h"
+#include "noff.h"
+
+#include <sys/stat.h>
+
+//----------------------------------------------------------------------
+// SwapHeader
+// 	Do little endian to big endian conversion on the bytes in the
+//	object file header, in case the file was generated on a little
+//	endian machine, and we're now running on a big endian machine.
+//----------------------------------------------------------------------
+
+static void
+SwapHeader (NoffHeader *noffH)
+{
+	noffH->noffMagic = WordToHost(noffH->noffMagic);
+	noffH->code.size = WordToHost(noffH->code.size);
+	noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
+	noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
+	noffH->initData.size = WordToHost(noffH->initData.size);
+	noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
+	noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
+	noffH->uninitData.size = WordToHost(noffH->uninitData.size);
+	noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
+	noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
+}
+
+//----------------------------------------------------------------------
+// ReadIdentity
+// 	Read what tells program files apart: the length and the NOFF
+//	header of "executable", and, with the UNIX stub file system, the
+//	device, inode and modification time of "fileName".
+//----------------------------------------------------------------------
+
+static void
+ReadIdentity(const char *fileName, OpenFile *executable, int *length,
+	     NoffHeader *noffH, dev_t *device, ino_t *inode, time_t *modified)
+{
+    *length = executable->Length();
+    memset(noffH, 0, sizeof(NoffHeader));
+    executable->ReadAt((char *)noffH, sizeof(NoffHeader), 0);
+    *device = 0;
+    *inode = 0;
+    *modified = 0;
+#ifdef FILESYS_STUB
+    struct stat info;
+
+    if (stat(fileName, &info) == 0) {
+	*device = info.st_dev;
+	*inode = info.st_ino;
+	*modified = info.st_mtime;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// ExecImage::ExecImage
+// 	Read the NOFF header of the program in "executable", and set up
+//	an image with no cached pages.  The image takes over "executable".
+//----------------------------------------------------------------------
+
+ExecImage::ExecImage(const char *fileName, OpenFile *executable)
+{
+    NoffHeader noffH;
+
+    ReadIdentity(fileName, executable, &fileLength, &header, &device,
+		 &inode, &modified);
+    noffH = header;
+    if ((noffH.noffMagic != NOFFMAGIC) &&
+		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
+	SwapHeader(&noffH);
+    ASSERT(noffH.noffMagic == NOFFMAGIC);
+
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+
+    codeSize = noffH.code.size;
+    initDataSize = noffH.initData.size;
+    uninitDataSize = noffH.uninitData.size;
+    inFileAddr = noffH.code.inFileAddr;
+
+    file = executable;
+    numPages = divRoundUp(codeSize, PageSize)
+		+ divRoundUp(initDataSize, PageSize);
+    pages = new char *[numPages];
+    for (int i = 0; i < numPages; i++)
+	pages[i] = NULL;
+    numCached = 0;
+
+    users = 0;
+    stale = false;
+    next = NULL;
+}
+
+//----------------------------------------------------------------------
+// ExecImage::~ExecImage
+// 	De-allocate the image, its cached pages, and close the file.
+//----------------------------------------------------------------------
+
+ExecImage::~ExecImage()
+{
+    for (int i = 0; i < numPages; i++)
+	delete [] pages[i];
+    delete [] pages;
+    delete [] name;
+    delete file;
+}
+
+//----------------------------------------------------------------------
+// ExecImage::SameFile
+// 	Return true if "executable", just opened as "fileName", is still
+//	the file the image was read from.
+//----------------------------------------------------------------------
+
+bool
+ExecImage::SameFile(const char *fileName, OpenFile *executable)
+{
+    int length;
+    NoffHeader noffH;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+
+    ReadIdentity(fileName, executable, &length, &noffH, &dev, &ino, &mtime);
+    return length == fileLength
+	&& memcmp(&noffH, &header, sizeof(NoffHeader)) == 0
+	&& dev == device && ino == inode && mtime == modified;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::ExecCache
+// 	Initialize an empty cache, that keeps at most "pageLimit" pages
+//	of program code and data.  With "pageLimit" 0 only the headers
+//	are kept.
+//----------------------------------------------------------------------
+
+ExecCache::ExecCache(int pageLimit)
+{
+    images = NULL;
+    maxPages = pageLimit;
+    numCached = 0;
+    numImages = 0;
+    numHits = numMisses = numInvalidations = 0;
+    pageHits = pageMisses = 0;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::~ExecCache
+// 	De-allocate every image still in the cache.
+//----------------------------------------------------------------------
+
+ExecCache::~ExecCache()
+{
+    while (images != NULL) {
+	ExecImage *image = images;
+	images = image->next;
+	delete image;
+    }
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Lookup
+// 	Return the image of the program "fileName", for a new address
+//	space, reading it if it isn't cached or if the file changed since
+//	it was.  The caller must call Release when it is done with it.
+//
+//	Returns NULL if the file can't be opened.
+//----------------------------------------------------------------------
+
+ExecImage *
+ExecCache::Lookup(const char *fileName)
+{
+    OpenFile *executable = fileSystem->Open(fileName);
+
+    if (executable == NULL)
+	return NULL;
+
+    for (ExecImage *image = images; image != NULL; image = image->next) {
+	if (strcmp(image->name, fileName) != 0)
+	    continue;
+	if (image->SameFile(fileName, executable)) {
+	    delete executable;			// the image has its own
+	    Unlink(image);			// most recently used first
+	    image->next = images;
+	    images = image;
+	    numImages++;
+	    image->users++;
+	    numHits++;
+	    DEBUG('a', "Exec cache hit on %s\n", fileName);
+	    return image;
+	}
+	DEBUG('a', "Exec cache: %s changed, dropping its image\n", fileName);
+	numInvalidations++;
+	Unlink(image);
+	Drop(image);
+	image->stale = true;
+	if (image->users == 0)
+	    delete image;
+	break;
+    }
+
+    ExecImage *image = new ExecImage(fileName, executable);
+    image->users = 1;
+    image->next = images;
+    images = image;
+    numImages++;
+    numMisses++;
+    Trim();
+    DEBUG('a', "Exec cache miss on %s, %d pages\n", fileName, image->numPages);
+    return image;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Retain, ExecCache::Release
+// 	Count the address spaces running "image".  An image that went
+//	stale is de-allocated when its last address space is done.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Retain(ExecImage *image)
+{
+    image->users++;
+}
+
+void
+ExecCache::Release(ExecImage *image)
+{
+    ASSERT(image->users > 0);
+    image->users--;
+    if (image->stale && image->users == 0)
+	delete image;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::ReadPage
+// 	Copy page "vpn" of the code and initialized data of the program
+//	into "into", from the cache if it is there, or otherwise from the
+//	program file, keeping a copy if there is room for it.
+//----------------------------------------------------------------------
+
+void
+ExecCache::ReadPage(ExecImage *image, unsigned int vpn, char *into)
+{
+    int position = image->inFileAddr + PageSize * vpn;
+
+    if ((int) vpn < image->numPages && image->pages[vpn] != NULL) {
+	memcpy(into, image->pages[vpn], PageSize);
+	pageHits++;
+	return;
+    }
+
+    pageMisses++;
+    if ((int) vpn >= image->numPages || image->stale || !MakeRoom()) {
+	image->file->ReadAt(into, PageSize, position);
+	return;
+    }
+
+    char *page = new char[PageSize];
+    memset(page, 0, PageSize);		// past the end of the file
+    image->file->ReadAt(page, PageSize, position);
+    image->pages[vpn] = page;
+    image->numCached++;
+    numCached++;
+    memcpy(into, page, PageSize);
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Unlink
+// 	Take "image" out of the list of cached images.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Unlink(ExecImage *image)
+{
+    ExecImage **link = &images;
+
+    while (*link != NULL && *link != image)
+	link = &(*link)->next;
+    if (*link == image) {
+	*link = image->next;
+	numImages--;
+    }
+    image->next = NULL;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Drop
+// 	Forget the cached pages of "image".
+//----------------------------------------------------------------------
+
+void
+ExecCache::Drop(ExecImage *image)
+{
+    for (int i = 0; i < image->numPages; i++) {
+	delete [] image->pages[i];
+	image->pages[i] = NULL;
+    }
+    numCached -= image->numCached;
+    image->numCached = 0;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::MakeRoom
+// 	Make sure there is room to cache one more page, dropping the
+//	pages of the least recently launched image that isn't running.
+//	Returns false if there is no such image.
+//----------------------------------------------------------------------
+
+bool
+ExecCache::MakeRoom()
+{
+    while (numCached >= maxPages) {
+	ExecImage *victim = NULL;
+	for (ExecImage *image = images; image != NULL; image = image->next)
+	    if (image->users == 0 && image->numCached > 0)
+		victim = image;			// the last one is the oldest
+	if (victim == NULL)
+	    return false;
+	DEBUG('a', "Exec cache drops the pages of %s\n", victim->name);
+	Drop(victim);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Trim
+// 	Delete the least recently launched images that aren't running,
+//	until at most ExecCacheMaxImages are left.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Trim()
+{
+    while (numImages > ExecCacheMaxImages) {
+	ExecImage *victim = NULL;
+	for (ExecImage *image = images; image != NULL; image = image->next)
+	    if (image->users == 0)
+		victim = image;			// the last one is the oldest
+	if (victim == NULL)
+	    return;
+	DEBUG('a', "Exec cache deletes the image of %s\n", victim->name);
+	Unlink(victim);
+	Drop(victim);
+	delete victim;
+    }
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Print
+// 	Print the exec cache statistics, at system shutdown.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Print()
+{
+    printf("Exec cache: hits %d, misses %d, invalidations %d\n",
+	numHits, numMisses, numInvalidations);
+    printf("Exec cache: page hits %d, page misses %d, pages %d/%d\n",
+	pageHits, pageMisses, numCached, maxPages);
+}
@@ -0,0 +1,115 @@
+// execcache.h
+//	Data structures for a kernel wide cache of program images, so
+//	that launching the same executable again and again (with Exec,
+//	or from the command line) doesn't cost a new parse of its NOFF
+//	header and a read of the program file on every code page fault.
+//
+//	An image keeps the segment layout of the program, an open file
+//	to read its pages from, and copies of the code and initialized
+//	data pages that have already been read.  Address spaces running
+//	the program share the image, and page faults on code or data
+//	pages are served from it.
+//
+//	Images are keyed by the name of the file, which is opened through
+//	the Nachos file system on every lookup, and checked against the
+//	file's length and NOFF header (and, when the Nachos files are UNIX
+//	files, their device, inode and modification time); if the file
+//	changed, the old image is dropped (once no address space uses it)
+//	and the program is read again.
+//
+//	The cached pages of all images together are limited to "maxPages";
+//	when the limit is reached, pages of the least recently launched
+//	images that are no longer running are dropped first, and if there
+//	are none, new pages are just not cached.  At most ExecCacheMaxImages
+//	images are kept; beyond that, the least recently launched ones that
+//	are no longer running are deleted, closing their files.
+
+#ifndef EXECCACHE_H
+#define EXECCACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "filesys.h"
+#include "noff.h"
+#include <sys/types.h>
+
+// Default number of program pages kept by the cache
+const int ExecCacheDefaultPages = 64;
+
+// Number of program images kept by the cache, when not running
+const int ExecCacheMaxImages = 16;
+
+// The following class defines the image of one program file.
+
+class ExecImage {
+  public:
+    ExecImage(const char *fileName, OpenFile *executable);
+    ~ExecImage();			// De-allocate the image and its pages
+
+    bool SameFile(const char *fileName, OpenFile *executable);
+					// Is "executable" still the file
+					// the image was read from?
+
+    char *name;				// program file
+    int fileLength;			// identity of the file when it was
+    NoffHeader header;			// read, to notice changes
+    dev_t device;			// (the last three only if the Nachos
+    ino_t inode;			// files are UNIX files)
+    time_t modified;
+
+    int codeSize;			// segment layout, from the NOFF header
+    int initDataSize;
+    int uninitDataSize;
+    int inFileAddr;			// where the code starts in the file
+
+    OpenFile *file;			// to read pages that aren't cached
+    int numPages;			// code and initialized data pages
+    char **pages;			// cached contents, NULL if not cached
+    int numCached;			// pages in "pages"
+
+    int users;				// address spaces running the image
+    bool stale;				// the file changed since it was read
+    ExecImage *next;			// in the cache, most recent first
+};
+
+// The following class defines the cache of program images.
+
+class ExecCache {
+  public:
+    ExecCache(int pageLimit);		// Initialize an empty cache, that
+					// keeps at most "pageLimit" pages
+    ~ExecCache();			// De-allocate the cached images
+
+    ExecImage *Lookup(const char *fileName);
+					// Image of "fileName", for a new
+					// address space; NULL if the file
+					// can't be opened
+    void Retain(ExecImage *image);	// One more address space uses it
+    void Release(ExecImage *image);	// An address space is done with it
+
+    void ReadPage(ExecImage *image, unsigned int vpn, char *into);
+					// Copy code or initialized data
+					// page "vpn" of the program into
+					// "into"
+    void Print();			// Print the cache statistics
+
+  private:
+    ExecImage *images;			// cached images, most recent first
+    int maxPages;			// limit on cached pages
+    int numCached;			// pages cached by all images
+    int numImages;			// images in "images"
+
+    int numHits;			// lookups that found the image
+    int numMisses;			// lookups that had to read the file
+    int numInvalidations;		// images dropped because the file
+					// changed
+    int pageHits;			// page reads served from the cache
+    int pageMisses;			// page reads from the file
+
+    void Unlink(ExecImage *image);	// take "image" out of the list
+    void Drop(ExecImage *image);	// forget the pages of "image"
+    bool MakeRoom();			// room for one more page
+    void Trim();			// keep at most ExecCacheMaxImages
+};
+
+#endif // EXECCACHE_H
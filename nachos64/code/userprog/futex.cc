@@ -0,0 +1,159 @@
+// futex.cc
+//	Routines to put threads to sleep on user addresses, and wake
+//	them up, for FutexWait and FutexWake.
+//
+//	All the table operations run with interrupts disabled, the same
+//	way Semaphore::P and Semaphore::V do, so checking the user
+//	counter and going to sleep can't be split by a FutexWake.
+
+#include "futex.h"
+#include "system.h"
+
+FutexTable::FutexTable()
+{
+	numBuckets = INITIAL_FUTEX_BUCKETS;
+	buckets = new FutexQueue*[ numBuckets ];
+	for ( int x = 0; x < numBuckets; ++x )
+		buckets[ x ] = NULL;
+	numQueues = 0;
+	numWaits = numRetries = numWakes = 0;
+}
+
+FutexTable::~FutexTable()
+{
+	for ( int x = 0; x < numBuckets; ++x ) {
+		FutexQueue* queue = buckets[ x ];
+		while ( queue != NULL ) {
+			FutexQueue* next = queue->next;
+			delete queue;
+			queue = next;
+		}
+	}
+	delete[] buckets;
+}
+
+unsigned int FutexTable::Hash( void* owner, int address )
+{
+	// counters are word aligned, so the low bits of "address" are 0
+	unsigned long key = (unsigned long) owner ^ ( (unsigned int) address >> 2 );
+	key ^= key >> 16;
+	key *= 0x45d9f3b;
+	key ^= key >> 16;
+	return (unsigned int) key & ( numBuckets - 1 );
+}
+
+FutexQueue* FutexTable::Find( void* owner, int address, bool create )
+{
+	unsigned int bucket = Hash( owner, address );
+	for ( FutexQueue* queue = buckets[ bucket ]; queue != NULL; queue = queue->next )
+		if ( queue->owner == owner && queue->address == address )
+			return queue;
+	if ( !create )
+		return NULL;
+
+	if ( numQueues >= numBuckets ) {	// keep the chains short
+		Rehash();
+		bucket = Hash( owner, address );
+	}
+	FutexQueue* queue = new FutexQueue;
+	queue->owner = owner;
+	queue->address = address;
+	queue->numWaiters = 0;
+	queue->next = buckets[ bucket ];
+	buckets[ bucket ] = queue;
+	++numQueues;
+	return queue;
+}
+
+void FutexTable::Free( FutexQueue* queue )
+{
+	FutexQueue** link = &buckets[ Hash( queue->owner, queue->address ) ];
+	while ( *link != queue )
+		link = &( *link )->next;
+	*link = queue->next;
+	delete queue;
+	--numQueues;
+}
+
+void FutexTable::Rehash()
+{
+	int oldBuckets = numBuckets;
+	FutexQueue** old = buckets;
+
+	numBuckets = oldBuckets * 2;
+	buckets = new FutexQueue*[ numBuckets ];
+	for ( int x = 0; x < numBuckets; ++x )
+		buckets[ x ] = NULL;
+	for ( int x = 0; x < oldBuckets; ++x ) {
+		FutexQueue* queue = old[ x ];
+		while ( queue != NULL ) {
+			FutexQueue* next = queue->next;
+			unsigned int bucket = Hash( queue->owner, queue->address );
+			queue->next = buckets[ bucket ];
+			buckets[ bucket ] = queue;
+			queue = next;
+		}
+	}
+	delete[] old;
+	DEBUG( 's', "Futex table grows to %d buckets\n", numBuckets );
+}
+
+int FutexTable::Wait( void* owner, int address, int expected )
+{
+	int value, physAddr;
+	IntStatus oldLevel;
+
+	// Bring the page in first: a page fault may block, and nothing
+	// may run between the check below and the Sleep.  With interrupts
+	// off the counter is only translated, never faulted on; if the
+	// page went away meanwhile, bring it in again.
+	for ( ;; ) {
+		if ( !machine->SafeReadMem( address, 4, &value ) )
+			return -1;
+		oldLevel = interrupt->SetLevel( IntOff );
+		if ( machine->Translate( address, &physAddr, 4, false )
+		     == NoException )
+			break;
+		interrupt->SetLevel( oldLevel );
+	}
+	value = WordToHost( *(unsigned int *) &machine->mainMemory[ physAddr ] );
+	if ( value != expected ) {	// a signal got in, let the user retry
+		++numRetries;
+		interrupt->SetLevel( oldLevel );
+		return -1;
+	}
+
+	FutexQueue* queue = Find( owner, address, true );
+	queue->waiters.Append( currentThread );
+	++queue->numWaiters;
+	++numWaits;
+	currentThread->Sleep();
+	interrupt->SetLevel( oldLevel );
+	return 0;
+}
+
+int FutexTable::Wake( void* owner, int address, int count )
+{
+	int woken = 0;
+	IntStatus oldLevel = interrupt->SetLevel( IntOff );
+
+	FutexQueue* queue = Find( owner, address, false );
+	if ( queue != NULL ) {
+		while ( woken < count && queue->numWaiters > 0 ) {
+			scheduler->ReadyToRun( queue->waiters.Remove() );
+			--queue->numWaiters;
+			++woken;
+		}
+		if ( queue->numWaiters == 0 )
+			Free( queue );
+	}
+	numWakes += woken;
+	interrupt->SetLevel( oldLevel );
+	return woken;
+}
+
+void FutexTable::Print()
+{
+	printf( "Futexes: %d waits, %d retries, %d wakes, %d buckets\n",
+		numWaits, numRetries, numWakes, numBuckets );
+}
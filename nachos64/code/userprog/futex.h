@@ -0,0 +1,66 @@
+// futex.h
+//	Data structures for the wait queues behind the FutexWait and
+//	FutexWake system calls.
+//
+//	A user semaphore made with the FutexSem type of syscall.h keeps
+//	its counter in the user's own memory, and updates it with an
+//	LL/SC sequence (see SemFastWait and SemFastSignal in start.s).
+//	The kernel is only entered when a thread finds the counter at
+//	zero and has to sleep, or when a signal finds someone sleeping.
+//
+//	The kernel only keeps the sleeping threads, in a wait queue per
+//	(process, user address).  A process is told apart by its semaphore
+//	table, which Fork shares with the new thread.  The queues live in a
+//	hash table that doubles its buckets as queues are added; a queue is
+//	made on the first FutexWait on an address and freed once it is
+//	empty, so the table holds only the addresses someone waits on.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "thread.h"
+#include "threadqueue.h"
+
+#define INITIAL_FUTEX_BUCKETS 16	// buckets in a new table
+
+// The following class defines the threads waiting on one user address.
+
+class FutexQueue {
+  public:
+    void* owner;		// semaphore table of the process
+    int address;		// user address of the counter
+    ThreadQueue waiters;	// threads sleeping on it, in FIFO order
+    int numWaiters;		// how many
+    FutexQueue* next;		// next queue in the same bucket
+};
+
+class FutexTable {
+  public:
+    FutexTable();		// Initialize an empty table
+    ~FutexTable();		// De-allocate
+
+    int Wait( void* owner, int address, int expected );
+				// Sleep on "address" if it still holds
+				// "expected"; return 0 once woken up,
+				// or -1 if the value had changed
+    int Wake( void* owner, int address, int count );
+				// Wake up to "count" threads sleeping on
+				// "address", return how many were woken
+    void Print();		// Print the table statistics
+
+  private:
+    FutexQueue** buckets;	// A vector with the hash chains
+    int numBuckets;		// A power of two
+    int numQueues;		// Queues in the table
+
+    int numWaits;		// threads put to sleep
+    int numRetries;		// FutexWait calls that found a new value
+    int numWakes;		// threads woken up
+
+    unsigned int Hash( void* owner, int address );
+    FutexQueue* Find( void* owner, int address, bool create );
+    void Free( FutexQueue* queue );	// Drop an empty queue
+    void Rehash();		// Double the number of buckets
+};
+
+#endif // FUTEX_H
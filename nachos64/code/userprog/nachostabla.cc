@@ -1,19 +1,33 @@
 #include "nachostabla.h"
+#include "pipe.h"
+#include <stdio.h>
+#include <unistd.h>
+
+// Handles are allocated lowest first.  The map is searched a word at
+// a time: words that are full are skipped, and the first free bit in
+// a word is found with a single instruction.  Words before
+// firstFreeWord are known to be full, so they are not even looked at.
 
 NachosOpenFilesTable::NachosOpenFilesTable()
 {
-	this->openFiles = new int[ MAX_FILES ];
+	this->size = INITIAL_FILES;
+	this->openFiles = new int[ size ];
 	this->openFiles[0] = 0; //std::in
 	this->openFiles[1] = 1; //std::out
 	this->openFiles[2] = 2; //std::cerr
 
-	for (int x = 3; x < MAX_FILES; ++x)
+	for (int x = 3; x < size; ++x)
 		 this->openFiles[x] = 0;
+	this->pipes = new NachosPipe*[ size ];
+	for (int x = 0; x < size; ++x)
+		 this->pipes[x] = NULL;
 
-	this->openFilesMap = new BitMap( MAX_FILES );
-	this->openFilesMap->Mark(0);
-	this->openFilesMap->Mark(1);
-	this->openFilesMap->Mark(2);
+	this->openFilesMap = new unsigned int[ size / BITS_IN_WORD ];
+	for (int x = 0; x < size / BITS_IN_WORD; ++x)
+		 this->openFilesMap[x] = 0;
+	this->openFilesMap[0] = 0x7;	// std::in, std::out and std::cerr
+	this->firstFreeWord = 0;
+	this->usage = 0;
 }
 
 
@@ -22,54 +36,141 @@ NachosOpenFilesTable::~NachosOpenFilesTable()
 	if(usage <= 0){
 			printf("Ultimo hilo borra tabla de archivos\n");
 			delete[] openFiles;
-			delete openFilesMap;
+			delete[] openFilesMap;
+			delete[] pipes;
 	}
 }
 
 bool NachosOpenFilesTable::isOpened( int NachosHandle ){
-    if(NachosHandle >= 0 && NachosHandle < MAX_FILES){
-        return openFilesMap->Test(NachosHandle);
+    if(NachosHandle >= 0 && NachosHandle < size){
+        return ( openFilesMap[ NachosHandle / BITS_IN_WORD ]
+                 >> ( NachosHandle % BITS_IN_WORD ) ) & 1;
     }
     return false;
 }
 
-int NachosOpenFilesTable:: Open( int UnixHandle )
+void NachosOpenFilesTable::Grow()
 {
-	int freeFile = this->openFilesMap->Find();
-	if (freeFile != -1)
-	{
-		this->openFiles[ freeFile ] = UnixHandle;
+	int newSize = size * 2;
+	int * newFiles = new int[ newSize ];
+	NachosPipe ** newPipes = new NachosPipe*[ newSize ];
+	unsigned int * newMap = new unsigned int[ newSize / BITS_IN_WORD ];
+
+	for (int x = 0; x < newSize; ++x) {
+		newFiles[x] = ( x < size ) ? openFiles[x] : 0;
+		newPipes[x] = ( x < size ) ? pipes[x] : NULL;
 	}
+	for (int x = 0; x < newSize / BITS_IN_WORD; ++x)
+		newMap[x] = ( x < size / BITS_IN_WORD ) ? openFilesMap[x] : 0;
+
+	delete[] openFiles;
+	delete[] pipes;
+	delete[] openFilesMap;
+	openFiles = newFiles;
+	pipes = newPipes;
+	openFilesMap = newMap;
+	size = newSize;
+}
+
+int NachosOpenFilesTable:: Open( int UnixHandle )
+{
+	int words = size / BITS_IN_WORD;
+	while ( firstFreeWord < words && openFilesMap[ firstFreeWord ] == ~0u )
+		++firstFreeWord;
+	if ( firstFreeWord == words )
+		Grow();
+
+	unsigned int word = openFilesMap[ firstFreeWord ];
+	int freeFile = firstFreeWord * BITS_IN_WORD + __builtin_ctz( ~word );
+	this->openFilesMap[ firstFreeWord ] = word | ( 1u << ( freeFile % BITS_IN_WORD ) );
+	this->openFiles[ freeFile ] = UnixHandle;
 	return freeFile;
 }
 
+int NachosOpenFilesTable::OpenPipe( NachosPipe* pipe, int end )
+{
+	int handle = Open( end );
+	this->pipes[ handle ] = pipe;
+	pipe->Open( end );
+	return handle;
+}
+
 int NachosOpenFilesTable::Close( int NachosHandle )
 {
     if(isOpened(NachosHandle)){
-	    this->openFilesMap->Clear( NachosHandle );
+	    int wordIndex = NachosHandle / BITS_IN_WORD;
+	    NachosPipe * pipe = this->pipes[ NachosHandle ];
+	    if ( pipe != NULL && pipe->Close( openFiles[ NachosHandle ] ) )
+		    delete pipe;	// that was the last handle on it
+	    this->openFilesMap[ wordIndex ] &= ~( 1u << ( NachosHandle % BITS_IN_WORD ) );
 	    this->openFiles[ NachosHandle ] = 0;
+	    this->pipes[ NachosHandle ] = NULL;
+	    if ( wordIndex < firstFreeWord )
+		    firstFreeWord = wordIndex;
         return	 0;
     }
     return -1;
 }
 
 int NachosOpenFilesTable::getUnixHandle( int NachosHandle ){
-    if(isOpened(NachosHandle)){
+    if(isOpened(NachosHandle) && pipes[NachosHandle] == NULL){
         return openFiles[NachosHandle];
     }
     return -1;
 }
 
+NachosPipe * NachosOpenFilesTable::getPipe( int NachosHandle ){
+    if(isOpened(NachosHandle)){
+        return pipes[NachosHandle];
+    }
+    return NULL;
+}
+
+// The child gets the same handle numbers as its parent.  Host files
+// are dup'ed, so each process can close its own copy.
+void NachosOpenFilesTable::Inherit( NachosOpenFilesTable* parent )
+{
+	while ( size < parent->size )
+		Grow();
+	for (int x = 3; x < parent->size; ++x) {
+		if ( !parent->isOpened( x ) || isOpened( x ) )
+			continue;
+		if ( parent->pipes[x] != NULL ) {
+			parent->pipes[x]->Open( parent->openFiles[x] );
+			pipes[x] = parent->pipes[x];
+			openFiles[x] = parent->openFiles[x];
+		} else {
+			int unixHandle = dup( parent->openFiles[x] );
+			if ( unixHandle == -1 )
+				continue;
+			openFiles[x] = unixHandle;
+		}
+		openFilesMap[ x / BITS_IN_WORD ] |= 1u << ( x % BITS_IN_WORD );
+	}
+}
+
+void NachosOpenFilesTable::CloseAll()
+{
+	for (int x = 3; x < size; ++x) {
+		if ( !isOpened( x ) )
+			continue;
+		if ( pipes[x] == NULL )
+			close( openFiles[x] );
+		Close( x );
+	}
+}
+
 void NachosOpenFilesTable::addThread(){
     ++usage;
 }
 
-void NachosOpenFilesTable::delThread(){
+bool NachosOpenFilesTable::delThread(){
     --usage;
+    return usage <= 0;
 }
 
 void NachosOpenFilesTable::Print(){
-    for(int i = 0; i < MAX_FILES; ++i){
+    for(int i = 0; i < size; ++i){
         printf("Nachos handle: %d, Unix handle: %d\n", i, openFiles[i]);
     }
     printf("\n");
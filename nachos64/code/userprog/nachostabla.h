@@ -1,10 +1,10 @@
 #ifndef NachosOpenFilesTable_H
 #define NachosOpenFilesTable_H
 
-#include "bitmap.h"
-
-#define MAX_FILES 128
+#define INITIAL_FILES 32	// handles in a new table, it grows as needed
+#define BITS_IN_WORD 32
 
+class NachosPipe;
 
 class NachosOpenFilesTable {
   public:
@@ -12,17 +12,30 @@ class NachosOpenFilesTable {
     ~NachosOpenFilesTable();      // De-allocate
 
     int Open( int UnixHandle ); // Register the file handle
+    int OpenPipe( NachosPipe* pipe, int end );	// Register a pipe end
     int Close( int NachosHandle );      // Unregister the file handle
     bool isOpened( int NachosHandle );
-    int getUnixHandle( int NachosHandle );
+    int getUnixHandle( int NachosHandle );	// -1 for a pipe end
+    NachosPipe* getPipe( int NachosHandle );	// NULL if not a pipe end
+    void Inherit( NachosOpenFilesTable* parent );	// Copy the handles
+				// of "parent", for an Exec'd child
+    void CloseAll();		// Close every handle but the console
     void addThread();		// If a user thread is using this table, add it
-    void delThread();		// If a user thread is using this table, delete it
+    bool delThread();		// If a user thread is using this table, delete
+				// it; true if no thread is using it now
 
     void Print();               // Print contents
 
   private:
-    int * openFiles;		// A vector with user opened files
-    BitMap * openFilesMap;	// A bitmap to control our vector
+    int * openFiles;		// A vector with user opened files, or the
+				// end of a pipe
+    NachosPipe ** pipes;		// The pipe of each handle, or NULL
+    unsigned int * openFilesMap;	// One bit per handle, set if in use
+    int size;			// Handles in "openFiles", a multiple of
+				// BITS_IN_WORD
+    int firstFreeWord;		// Every word before this one is full
     int usage;			// How many threads are using this table
+
+    void Grow();		// Double the number of handles
 };
 #endif
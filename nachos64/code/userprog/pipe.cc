@@ -0,0 +1,109 @@
+// pipe.cc
+//	Routines to move data through a pipe.  The user buffers are
+//	copied straight to and from the ring, a contiguous piece at a
+//	time, so no bytes are copied twice.
+
+#include "pipe.h"
+#include "system.h"
+
+NachosPipe::NachosPipe()
+{
+	head = 0;
+	count = 0;
+	readers = 0;
+	writers = 0;
+	lock = new Lock( "pipe" );
+	notEmpty = new Condition( "pipe not empty" );
+	notFull = new Condition( "pipe not full" );
+}
+
+NachosPipe::~NachosPipe()
+{
+	delete lock;
+	delete notEmpty;
+	delete notFull;
+}
+
+int NachosPipe::Read( int into, int size )
+{
+	int done = 0;
+	bool fault = false;
+
+	if ( size == 0 )		// nothing to wait for
+		return 0;
+	lock->Acquire();
+	while ( count == 0 && writers > 0 )
+		notEmpty->Wait( lock );
+	while ( done < size && count > 0 ) {
+		int chunk = size - done;
+		if ( chunk > count )
+			chunk = count;
+		if ( chunk > PIPE_SIZE - head )	// up to the end of the ring
+			chunk = PIPE_SIZE - head;
+		if ( !machine->SafeWriteBlock( into + done, chunk, buffer + head ) ) {
+			fault = true;	// bad user buffer, leave the rest
+			break;
+		}
+		head = ( head + chunk ) % PIPE_SIZE;
+		count -= chunk;
+		done += chunk;
+	}
+	if ( done > 0 )
+		notFull->Broadcast( lock );
+	lock->Release();
+	return fault ? -1 : done;
+}
+
+int NachosPipe::Write( int from, int size )
+{
+	int done = 0;
+	bool fault = false;
+
+	lock->Acquire();
+	while ( done < size ) {
+		while ( count == PIPE_SIZE && readers > 0 )
+			notFull->Wait( lock );
+		if ( readers == 0 )		// broken pipe
+			break;
+		int tail = ( head + count ) % PIPE_SIZE;
+		int chunk = size - done;
+		if ( chunk > PIPE_SIZE - count )
+			chunk = PIPE_SIZE - count;
+		if ( chunk > PIPE_SIZE - tail )	// up to the end of the ring
+			chunk = PIPE_SIZE - tail;
+		if ( !machine->SafeReadBlock( from + done, chunk, buffer + tail ) ) {
+			fault = true;	// bad user buffer
+			break;
+		}
+		count += chunk;
+		done += chunk;
+		notEmpty->Broadcast( lock );
+	}
+	lock->Release();
+	return ( fault || ( done == 0 && size > 0 ) ) ? -1 : done;
+}
+
+void NachosPipe::Open( int end )
+{
+	lock->Acquire();
+	if ( end == PipeReadEnd )
+		++readers;
+	else
+		++writers;
+	lock->Release();
+}
+
+bool NachosPipe::Close( int end )
+{
+	lock->Acquire();
+	if ( end == PipeReadEnd )
+		--readers;
+	else
+		--writers;
+	// wake up everyone, to see end of file or a broken pipe
+	notEmpty->Broadcast( lock );
+	notFull->Broadcast( lock );
+	bool last = ( readers == 0 && writers == 0 );
+	lock->Release();
+	return last;
+}
@@ -0,0 +1,53 @@
+// pipe.h
+//	Data structures for the pipes made with the Pipe system call.
+//
+//	A pipe is a bounded ring buffer in the kernel, with a read end and
+//	a write end.  Each end is a handle in the open files table of the
+//	processes that use it (see nachostabla.h); Exec'd children inherit
+//	them, so a parent can plug its children into a pipeline.
+//
+//	Read blocks while the pipe is empty, and returns what is there, up
+//	to "size" bytes, or 0 once every write end is closed; a Read of 0
+//	bytes returns 0 without blocking.  Write blocks while the pipe is
+//	full, until all of "size" is in; it stops early if every read end
+//	is closed.  Nothing touches the host file system.
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "synch.h"
+
+#define PIPE_SIZE 1024		// bytes buffered in a pipe
+
+#define PipeReadEnd 0
+#define PipeWriteEnd 1
+
+class NachosPipe {
+  public:
+    NachosPipe();		// Initialize an empty pipe, no ends open
+    ~NachosPipe();		// De-allocate
+
+    int Read( int into, int size );	// Copy up to "size" bytes into
+				// user memory at "into", return how many,
+				// 0 at end of file, -1 on a bad buffer
+    int Write( int from, int size );	// Copy "size" bytes from user
+				// memory at "from", return how many, or -1
+				// if nobody can read them or on a bad
+				// buffer
+    void Open( int end );	// One more handle on "end"
+    bool Close( int end );	// One less handle on "end", return true
+				// if it was the last handle on either end,
+				// so the pipe can be deleted
+
+  private:
+    char buffer[ PIPE_SIZE ];	// The ring buffer
+    int head;			// First byte to read
+    int count;			// Bytes in the buffer
+    int readers;		// Handles on the read end
+    int writers;		// Handles on the write end
+    Lock* lock;			// Protects all of the above
+    Condition* notEmpty;	// Readers wait here for data
+    Condition* notFull;		// Writers wait here for room
+};
+
+#endif // PIPE_H
@@ -0,0 +1,171 @@
+// proctable.cc
+//	Routines to keep track of user processes.
+
+#include "proctable.h"
+
+Process::Process( int spaceId, Thread* runner, Process* creator,
+		  const std::string& program )
+{
+	id = spaceId;
+	thread = runner;
+	fileName = program;
+	parent = creator;
+	firstChild = NULL;
+	prevSibling = NULL;
+	nextSibling = NULL;
+	if ( parent != NULL )	// link into the parent's children
+	{
+		nextSibling = parent->firstChild;
+		if ( nextSibling != NULL )
+			nextSibling->prevSibling = this;
+		parent->firstChild = this;
+	}
+	numThreads = 1;
+	exited = false;
+	exitStatus = 0;
+	joining = false;
+	joined = false;
+	exitSem = new Semaphore( "process exit", 0 );
+}
+
+Process::~Process()
+{
+	delete exitSem;
+}
+
+ProcessTable::ProcessTable()
+{
+	size = INITIAL_PROCESSES;
+	processes = new Process*[ size ];
+	freeIds = new int[ size ];
+	numFree = 0;
+	for ( int x = size - 1; x >= 0; --x )	// lowest ids first
+	{
+		processes[ x ] = NULL;
+		freeIds[ numFree++ ] = x;
+	}
+}
+
+ProcessTable::~ProcessTable()
+{
+	for ( int x = 0; x < size; ++x )
+		delete processes[ x ];
+	delete[] processes;
+	delete[] freeIds;
+}
+
+void ProcessTable::Grow()
+{
+	int newSize = size * 2;
+	Process** newProcesses = new Process*[ newSize ];
+	int* newFreeIds = new int[ newSize ];
+
+	for ( int x = 0; x < size; ++x )
+		newProcesses[ x ] = processes[ x ];
+	for ( int x = 0; x < numFree; ++x )
+		newFreeIds[ x ] = freeIds[ x ];
+	for ( int x = newSize - 1; x >= size; --x )
+	{
+		newProcesses[ x ] = NULL;
+		newFreeIds[ numFree++ ] = x;
+	}
+	delete[] processes;
+	delete[] freeIds;
+	processes = newProcesses;
+	freeIds = newFreeIds;
+	size = newSize;
+}
+
+Process* ProcessTable::Create( Thread* thread, Process* parent,
+			       const std::string& fileName )
+{
+	if ( numFree == 0 )
+		Grow();
+	int id = freeIds[ --numFree ];
+	processes[ id ] = new Process( id, thread, parent, fileName );
+	return processes[ id ];
+}
+
+Process* ProcessTable::Get( int id )
+{
+	if ( id < 0 || id >= size )
+		return NULL;
+	return processes[ id ];
+}
+
+void ProcessTable::Reap( Process* process )
+{
+	if ( process->parent != NULL )	// unlink from the parent's children
+	{
+		if ( process->prevSibling != NULL )
+			process->prevSibling->nextSibling = process->nextSibling;
+		else
+			process->parent->firstChild = process->nextSibling;
+		if ( process->nextSibling != NULL )
+			process->nextSibling->prevSibling = process->prevSibling;
+	}
+	processes[ process->id ] = NULL;
+	freeIds[ numFree++ ] = process->id;
+	delete process;
+}
+
+void ProcessTable::MaybeReap( Process* process )
+{
+	if ( process->numThreads == 0 && process->exited && !process->joining
+	     && ( process->joined || process->parent == NULL ) )
+		Reap( process );
+}
+
+void ProcessTable::AddThread( Process* process )
+{
+	ASSERT( process->numThreads > 0 );
+	++process->numThreads;
+}
+
+void ProcessTable::ThreadExit( Process* process )
+{
+	ASSERT( process->numThreads > 0 );
+	--process->numThreads;
+	MaybeReap( process );
+}
+
+void ProcessTable::Exit( Process* process, int status )
+{
+	ASSERT( !process->exited );
+	process->exited = true;
+	process->exitStatus = status;
+	process->thread = NULL;		// it is about to be destroyed
+
+	// Our children become orphans; the ones that are done are reaped
+	Process* child = process->firstChild;
+	while ( child != NULL )
+	{
+		Process* next = child->nextSibling;
+		child->parent = NULL;
+		child->prevSibling = child->nextSibling = NULL;
+		MaybeReap( child );
+		child = next;
+	}
+	process->firstChild = NULL;
+
+	if ( process->joining )
+		process->exitSem->V();
+	MaybeReap( process );	// if this wasn't called by its last thread
+}
+
+int ProcessTable::Join( Process* caller, int id )
+{
+	Process* process = Get( id );
+	if ( process == NULL || caller == NULL || process->parent != caller
+	     || process->joining || process->joined )
+		return -1;
+
+	process->joining = true;
+	if ( !process->exited )
+		process->exitSem->P();
+	int status = process->exitStatus;
+	process->joining = false;
+	process->joined = true;
+	MaybeReap( process );
+	return status;
+}
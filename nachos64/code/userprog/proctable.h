@@ -0,0 +1,83 @@
+// proctable.h
+//	Data structures to keep track of the user processes started with
+//	Exec (and the first one, started from the command line).
+//
+//	Each process has an entry in a kernel wide table, indexed by its
+//	SpaceId, so Exit and Join find it in constant time.  The table
+//	grows as needed; freed ids are kept in a stack and reused first.
+//
+//	A process exits when the thread that Exec started calls Exit, but
+//	the threads it Forked keep running in it.  Its entry stays in the
+//	table, holding the exit status, until it is reaped: once its last
+//	thread is done, and its parent has Joined it, or if nobody is going
+//	to Join it, the parent exited.  Children of a process that exits
+//	become orphans, and are reaped as soon as they are done.
+
+#ifndef PROCTABLE_H
+#define PROCTABLE_H
+
+#include "synch.h"
+#include "consolebuffer.h"
+#include <string>
+
+#define INITIAL_PROCESSES 128
+
+class Thread;
+
+// The following class defines one user process.
+
+class Process {
+  public:
+	Process( int spaceId, Thread* runner, Process* creator,
+		 const std::string& program );
+	~Process();
+
+	int id;			// SpaceId returned by Exec
+	Thread* thread;		// the thread that runs the program
+	std::string fileName;	// the program
+	Process* parent;	// the process that called Exec, or NULL
+	Process* firstChild;	// processes this one started, that were
+	Process* nextSibling;	// not reaped yet
+	Process* prevSibling;
+
+	int numThreads;		// threads still running in the process
+	bool exited;		// Exit was called
+	int exitStatus;		// the value given to Exit
+	bool joining;		// the parent is waiting in Join
+	bool joined;		// the parent got the exit status
+	Semaphore* exitSem;	// signaled when the process exits
+	ConsoleLine consoleLine;	// console output not yet in a line
+};
+
+class ProcessTable {
+  public:
+	ProcessTable();		// Initialize
+	~ProcessTable();	// De-allocate
+
+	Process* Create( Thread* thread, Process* parent,
+			 const std::string& fileName );
+				// Register a new process
+	Process* Get( int id );	// The process with SpaceId "id", or NULL
+	void AddThread( Process* process );
+				// A thread was Forked in the process
+	void ThreadExit( Process* process );
+				// One of its threads is done
+	void Exit( Process* process, int status );
+				// The process is done
+	int Join( Process* caller, int id );
+				// Wait for process "id" to exit, return
+				// its exit status, or -1 if "id" isn't a
+				// child of "caller" that can be joined
+
+  private:
+	Process** processes;	// A vector indexed by SpaceId
+	int size;		// entries in "processes"
+	int* freeIds;		// A stack with the unused SpaceIds
+	int numFree;		// entries in "freeIds"
+
+	void Grow();		// Double the size of the table
+	void Reap( Process* process );	// Free the entry of "process"
+	void MaybeReap( Process* process );	// Reap it if nobody needs it
+};
+
+#endif // PROCTABLE_H
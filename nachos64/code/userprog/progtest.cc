@@ -32,6 +32,8 @@ StartProcess(const char *filename)
     }
     space = new AddrSpace(executable, filename );
     currentThread->space = space;
+    currentThread->process = processTable->Create(currentThread, NULL,
+						    filename);
 
     delete executable;			// close file
 
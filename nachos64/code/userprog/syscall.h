@@ -33,6 +33,32 @@
 #define SC_SemDestroy	12
 #define SC_SemSignal	13
 #define SC_SemWait	14
+#define SC_Mmap		15
+#define SC_Munmap	16
+#define SC_SubmitBatch	17
+#define SC_ReadAsync	18
+#define SC_WriteAsync	19
+#define SC_WaitIO	20
+#define SC_Seek		21
+#define SC_PRead	22
+#define SC_PWrite	23
+#define SC_FutexWait	24
+#define SC_FutexWake	25
+#define SC_Pipe		26
+#define SC_ShmCreate	27
+#define SC_ShmAttach	28
+#define SC_ShmDetach	29
+#define SC_SetPriority	30
+#define SC_GetPriority	31
+#define SC_Sleep	32
+
+/* Layout of a SubmitBatch ring in user memory, in bytes, for the kernel */
+#define SyscallRingSize		32	/* max requests in a ring */
+#define SyscallRequestSize	20	/* op, 3 arguments, result */
+#define SyscallRingHead		0
+#define SyscallRingTail		4
+#define SyscallRingSizeOffset	8
+#define SyscallRingEntries	12
 
 #ifndef IN_ASM
 
@@ -64,7 +90,10 @@ typedef int SpaceId;
 SpaceId Exec(char *name);
 
 /* Only return once the the user program "id" has finished.
- * Return the exit status.
+ * Return the exit status, even if it had already finished, or -1 if
+ * "id" is not a program that can be joined.  Only the program that
+ * Exec'd "id" can join it, and only once; if it exits first without
+ * joining it, its SpaceId is freed when it finishes.
  */
 int Join(SpaceId id);
 
@@ -143,6 +172,158 @@ int SemSignal( int SemId );
 /* SemWait waits a semaphore, some other thread may awake if one blocked */
 int SemWait( int SemId );
 
+
+/* Memory mapped files: Mmap and Munmap.  The pages of the mapping are
+ * read from the file when first touched, and modified pages are written
+ * back when they are evicted or when the file is unmapped.
+ */
+
+/* Map the first "length" bytes of the file "name" into the address space.
+ * Return the address of the mapping, or -1 on error.  Mappings and shared
+ * segments can only reach MaxMappedPages (see addrspace.h) past the stack.
+ */
+int Mmap( char *name, int length );
+
+/* Unmap the mapping that starts at "addr", writing back modified pages.
+ * Return 0, or -1 if there is no mapping at "addr".
+ */
+int Munmap( int addr );
+
+
+/* Shared memory segments.  ShmCreate makes a segment of "size" bytes,
+ * and returns its id (or -1).  Any process that knows the id can map the
+ * segment with ShmAttach, at the page aligned address "addr" past its
+ * stack, or after its last mapping if "addr" is 0; every process that
+ * attaches a segment sees the same physical pages.  ShmAttach returns the
+ * address of the segment, or -1.  ShmDetach unmaps the segment attached
+ * at "addr", and returns 0 or -1.  Segments are detached on Exit, and a
+ * segment is freed when nothing is attached to it any more.
+ */
+int ShmCreate( int size );
+
+int ShmAttach( int id, int addr );
+
+int ShmDetach( int addr );
+
+
+/* Scheduling priority of the calling thread, from 0 (most urgent) to 3.
+ * A thread never runs at a more urgent level than its priority; under
+ * load it may drop below it.  Threads start with the priority of the
+ * thread that made them.  A thread can only lower its own priority
+ * (give a larger number), never raise it.  SetPriority returns the
+ * previous priority, or -1 if "priority" is out of range or more urgent
+ * than the current one.
+ */
+int SetPriority( int priority );
+
+int GetPriority();
+
+/* Block the calling thread for "ticks" ticks of simulated time.  The
+ * thread is off the ready list while it sleeps, so if nothing else can
+ * run, the machine skips ahead to the wakeup.  Returns 0.
+ */
+int Sleep( int ticks );
+
+
+/* Batched system calls.  A user program queues Read, Write and SemSignal
+ * requests in a ring in its own memory, and runs all of them with a
+ * single SubmitBatch trap.  To queue a request, fill in
+ * entries[head % size] and increment head.  The kernel runs the requests
+ * from tail to head, in order, storing each return value in its "result"
+ * field and incrementing tail as it goes.  Requests for any other system
+ * call, and Reads and Writes that could block (console input, pipes),
+ * complete with a result of -1.  The call fails if more than "size"
+ * requests are queued.
+ */
+typedef struct {
+    int op;		/* SC_Read, SC_Write or SC_SemSignal */
+    int arg1;		/* arguments, as for the system call */
+    int arg2;
+    int arg3;
+    int result;		/* set by the kernel on completion */
+} SyscallRequest;
+
+typedef struct {
+    int head;		/* next request to queue, written by the user */
+    int tail;		/* next request to run, written by the kernel */
+    int size;		/* entries in use, at most SyscallRingSize */
+    SyscallRequest entries[SyscallRingSize];
+} SyscallRing;
+
+/* Run every queued request, return how many were run or -1 on error */
+int SubmitBatch( SyscallRing *ring );
+
+
+/* Asynchronous I/O.  ReadAsync and WriteAsync start a transfer like Read
+ * and Write, and return right away with a request id (or -1 if too many
+ * requests are pending).  When the transfer is done, the semaphore
+ * "semId" (from SemCreate) is signaled, unless it is -1.  WaitIO waits
+ * for the request to finish, frees its id, and returns the number of
+ * bytes transferred, or -1.  Every request must be waited for once.
+ */
+int ReadAsync( char *buffer, int size, OpenFileId id, int semId );
+
+int WriteAsync( char *buffer, int size, OpenFileId id, int semId );
+
+int WaitIO( int requestId );
+
+
+/* Positional I/O.  Seek moves the current position of an open file
+ * ("whence" is SeekSet, SeekCur or SeekEnd, as in UNIX lseek) and returns
+ * the new position, or -1.  PRead and PWrite are like Read and Write, but
+ * transfer at position "offset", and don't move the current position.
+ * The console can't be used with any of them.
+ */
+#define SeekSet		0
+#define SeekCur		1
+#define SeekEnd		2
+
+int Seek( OpenFileId id, int offset, int whence );
+
+int PRead( char *buffer, int size, OpenFileId id, int offset );
+
+int PWrite( char *buffer, int size, OpenFileId id, int offset );
+
+
+/* Futex semaphores.  A FutexSem lives in user memory, and is set up by
+ * storing its initial value in "count" and 0 in "waiters".  SemFastWait
+ * and SemFastSignal update it with an atomic LL/SC sequence, and only
+ * trap into the kernel when a thread has to sleep, or a sleeper has to
+ * be woken up.  They always return 0.  A FutexSem can be shared by the
+ * threads of a process (Fork), but not by different processes.
+ *
+ * FutexWait sleeps on "addr" if *addr still equals "expected", and
+ * returns 0 when woken up, or -1 right away if *addr has changed.
+ * FutexWake wakes up to "count" threads sleeping on "addr", and returns
+ * how many were woken up.
+ */
+typedef struct {
+    int count;		/* value of the semaphore */
+    int waiters;	/* threads in (or about to be in) FutexWait */
+} FutexSem;
+
+int SemFastWait( FutexSem *sem );
+
+int SemFastSignal( FutexSem *sem );
+
+int FutexWait( int *addr, int expected );
+
+int FutexWake( int *addr, int count );
+
+
+/* Pipes.  Pipe makes a pipe in the kernel, and stores the handle of its
+ * read end in ends[0] and of its write end in ends[1].  They are used
+ * with Read, Write and Close like any open file (but not with Seek, PRead
+ * or PWrite).  Read blocks until there is something in the pipe, and
+ * returns 0 once every write end is closed (or right away, if asked for
+ * 0 bytes); Write blocks while the pipe is full, and returns -1 if every
+ * read end is closed.  Exec'd children get a copy of every open handle
+ * of their parent, with the same numbers, and all of a process's handles
+ * are closed when it exits.  Returns 0, or -1 on error (then no pipe is
+ * made).
+ */
+int Pipe( OpenFileId *ends );
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
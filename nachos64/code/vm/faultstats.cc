@@ -0,0 +1,258 @@
+// faultstats.cc
+//	Routines to classify page faults and to report where the page
+//	fault handler spends its time.  See faultstats.h.
+
+#include "copyright.h"
+#include "faultstats.h"
+#include "system.h"
+
+static const char *faultKindNames[] = { "tlb_refill", "zero_fill",
+			"executable", "swap_in", "file_fill" };
+
+//----------------------------------------------------------------------
+// FaultRecord::FaultRecord
+// 	Initialize the fault counts of one address space.
+//----------------------------------------------------------------------
+
+FaultRecord::FaultRecord(int recordId, const char *programName)
+{
+    id = recordId;
+    name = new char[strlen(programName) + 1];
+    strcpy(name, programName);
+    for (int k = 0; k < NumFaultKinds; k++)
+	counts[k] = 0;
+    evictions = 0;
+    pageCounts = NULL;
+    numPageCounts = 0;
+    next = NULL;
+}
+
+FaultRecord::~FaultRecord()
+{
+    delete [] name;
+    delete [] pageCounts;
+}
+
+//----------------------------------------------------------------------
+// FaultRecord::CountPage
+// 	Count one more fault on virtual page "vpn", growing the per page
+//	counters if the address space has grown (Mmap).
+//----------------------------------------------------------------------
+
+void
+FaultRecord::CountPage(unsigned int vpn)
+{
+    if (vpn >= numPageCounts) {
+	unsigned int size = (numPageCounts > 0) ? numPageCounts : 16;
+	while (size <= vpn)
+	    size *= 2;
+	int *counters = new int[size];
+	for (unsigned int i = 0; i < size; i++)
+	    counters[i] = (i < numPageCounts) ? pageCounts[i] : 0;
+	delete [] pageCounts;
+	pageCounts = counters;
+	numPageCounts = size;
+    }
+    pageCounts[vpn]++;
+}
+
+//----------------------------------------------------------------------
+// FaultStats::FaultStats
+// 	Initialize the page fault statistics to zero.
+//
+//	"reportName" is the file the JSON report is written to at halt.
+//----------------------------------------------------------------------
+
+FaultStats::FaultStats(const char *reportName)
+{
+    fileName = new char[strlen(reportName) + 1];
+    strcpy(fileName, reportName);
+    for (int k = 0; k < NumFaultKinds; k++) {
+	counts[k] = 0;
+	hostTime[k] = 0;
+    }
+    cleanEvictions = dirtyEvictions = 0;
+    kind = TLBRefillFault;
+    faultEvictions = 0;
+    startHostTime = 0;
+    records = lastRecord = NULL;
+    numRecords = 0;
+}
+
+FaultStats::~FaultStats()
+{
+    while (records != NULL) {
+	FaultRecord *record = records;
+	records = records->next;
+	delete record;
+    }
+    delete [] fileName;
+}
+
+//----------------------------------------------------------------------
+// FaultStats::Begin
+// 	Start timing a page fault.  Until told otherwise, a fault is
+//	assumed to be a TLB refill.
+//----------------------------------------------------------------------
+
+void
+FaultStats::Begin()
+{
+    kind = TLBRefillFault;
+    faultEvictions = 0;
+    startHostTime = HostTime();
+}
+
+//----------------------------------------------------------------------
+// FaultStats::SetKind
+// 	Record what the kernel had to do to resolve the current fault.
+//----------------------------------------------------------------------
+
+void
+FaultStats::SetKind(FaultKind faultKind)
+{
+    kind = faultKind;
+}
+
+//----------------------------------------------------------------------
+// FaultStats::Evicted
+// 	Record that the current fault had to evict a victim page.
+//
+//	"dirty" is true if the victim had to be written out.
+//----------------------------------------------------------------------
+
+void
+FaultStats::Evicted(bool dirty)
+{
+    if (dirty)
+	dirtyEvictions++;
+    else
+	cleanEvictions++;
+    faultEvictions++;
+}
+
+//----------------------------------------------------------------------
+// FaultStats::End
+// 	Account for a resolved fault on page "vpn".
+//
+//	"record" points to the fault record of the faulting address
+//	space; it is created here on the space's first fault.
+//	"programName" names the address space in the report.
+//----------------------------------------------------------------------
+
+void
+FaultStats::End(FaultRecord **record, const char *programName,
+		unsigned int vpn)
+{
+    counts[kind]++;
+    hostTime[kind] += HostTime() - startHostTime;
+
+    if (*record == NULL) {
+	*record = new FaultRecord(numRecords++, programName);
+	if (lastRecord == NULL)
+	    records = *record;
+	else
+	    lastRecord->next = *record;
+	lastRecord = *record;
+    }
+    (*record)->counts[kind]++;
+    (*record)->evictions += faultEvictions;
+    (*record)->CountPage(vpn);
+}
+
+//----------------------------------------------------------------------
+// WriteHotPages
+// 	Write the "FaultHotListSize" most faulted pages among "records"
+//	as a JSON array.  If "only" is not NULL, just its pages count.
+//----------------------------------------------------------------------
+
+static void
+WriteHotPages(FILE *out, FaultRecord *records, FaultRecord *only)
+{
+    int lastCount = -1;			// pick pages in decreasing order
+    FaultRecord *lastRecord = NULL;	// of (count, record, vpn) below
+    unsigned int lastVpn = 0;		// the one picked before
+
+    fprintf(out, "[");
+    for (int n = 0; n < FaultHotListSize; n++) {
+	FaultRecord *best = NULL;
+	unsigned int bestVpn = 0;
+	int bestCount = 0;
+
+	for (FaultRecord *r = records; r != NULL; r = r->next) {
+	    if (only != NULL && r != only)
+		continue;
+	    for (unsigned int vpn = 0; vpn < r->numPageCounts; vpn++) {
+		int count = r->pageCounts[vpn];
+		if (count == 0)
+		    continue;
+		// skip anything already written
+		if (lastCount != -1 && (count > lastCount
+		    || (count == lastCount && (r->id < lastRecord->id
+		    || (r == lastRecord && vpn <= lastVpn)))))
+		    continue;
+		if (count > bestCount) {
+		    best = r;
+		    bestVpn = vpn;
+		    bestCount = count;
+		}
+	    }
+	}
+	if (best == NULL)
+	    break;
+	fprintf(out, "%s{\"space\": %d, \"vpn\": %u, \"faults\": %d}",
+		(n > 0) ? ", " : "", best->id, bestVpn, bestCount);
+	lastCount = bestCount;
+	lastRecord = best;
+	lastVpn = bestVpn;
+    }
+    fprintf(out, "]");
+}
+
+//----------------------------------------------------------------------
+// FaultStats::WriteReport
+// 	Write all the page fault statistics to "fileName", as JSON.
+//----------------------------------------------------------------------
+
+void
+FaultStats::WriteReport()
+{
+    FILE *out = fopen(fileName, "w");
+    int total = 0;
+    int k;
+
+    if (out == NULL) {
+	perror("Unable to write the page fault report");
+	return;
+    }
+
+    for (k = 0; k < NumFaultKinds; k++)
+	total += counts[k];
+    fprintf(out, "{\n  \"total_faults\": %d,\n", total);
+    fprintf(out, "  \"kinds\": {\n");
+    for (k = 0; k < NumFaultKinds; k++)
+	fprintf(out, "    \"%s\": {\"count\": %d, \"host_usec\": %lld}%s\n",
+		faultKindNames[k], counts[k], hostTime[k],
+		(k < NumFaultKinds - 1) ? "," : "");
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"evictions\": {\"clean\": %d, \"dirty\": %d},\n",
+	    cleanEvictions, dirtyEvictions);
+
+    fprintf(out, "  \"spaces\": [\n");
+    for (FaultRecord *r = records; r != NULL; r = r->next) {
+	fprintf(out, "    {\"space\": %d, \"program\": ", r->id);
+	WriteJSONString(out, r->name);
+	fprintf(out, ", ");
+	for (k = 0; k < NumFaultKinds; k++)
+	    fprintf(out, "\"%s\": %d, ", faultKindNames[k], r->counts[k]);
+	fprintf(out, "\"evictions\": %d,\n      \"hot_pages\": ", r->evictions);
+	WriteHotPages(out, records, r);
+	fprintf(out, "}%s\n", (r->next != NULL) ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+
+    fprintf(out, "  \"hot_pages\": ");
+    WriteHotPages(out, records, NULL);
+    fprintf(out, "\n}\n");
+    fclose(out);
+}
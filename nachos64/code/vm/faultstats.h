@@ -0,0 +1,88 @@
+// faultstats.h
+//	Data structures for page fault telemetry.
+//
+//	Every PageFaultException is classified by what the kernel had to
+//	do to resolve it:
+//
+//		TLB refill -- the page was resident, only the TLB was loaded
+//		zero fill  -- a fresh uninitialized data or stack page
+//		executable -- a code or initialized data page read from
+//			      the program file
+//		swap in    -- the page was brought back from the swap
+//		file fill  -- a page of a memory mapped file (Mmap)
+//
+//	and, independently, by whether a clean or a dirty victim had to
+//	be evicted to make room.  For each class we keep the number of
+//	faults and the host time spent handling them.  (Simulated time
+//	doesn't advance while the handler runs, so it isn't kept.)
+//	Fault counts are also kept per address space and per virtual page,
+//	to find the hot pages.
+//
+//	The whole set is written as a JSON report when Nachos halts.
+
+#ifndef FAULTSTATS_H
+#define FAULTSTATS_H
+
+#include "copyright.h"
+#include "utility.h"
+
+enum FaultKind { TLBRefillFault, ZeroFillFault, ExecutableFault,
+		 SwapInFault, FileFillFault, NumFaultKinds };
+
+// Number of entries in each hot page list of the report
+const int FaultHotListSize = 10;
+
+// The following class defines the faults taken by one address space.
+
+class FaultRecord {
+  public:
+    FaultRecord(int recordId, const char *programName);
+    ~FaultRecord();
+
+    void CountPage(unsigned int vpn);	// one more fault on "vpn"
+
+    int id;				// order of creation, for the report
+    char *name;				// program the address space runs
+    int counts[NumFaultKinds];		// faults of each kind
+    int evictions;			// victims evicted by these faults
+    int *pageCounts;			// faults on each virtual page
+    unsigned int numPageCounts;		// size of "pageCounts"
+    FaultRecord *next;			// all records, for the report
+};
+
+// The following class defines the kernel wide page fault statistics.
+// The page fault handler calls Begin before AddrSpace::load, and End
+// after it; load reports the kind of fault and any eviction in between.
+
+class FaultStats {
+  public:
+    FaultStats(const char *reportName);	// report goes to "reportName"
+    ~FaultStats();
+
+    void Begin();			// a page fault starts
+    void SetKind(FaultKind kind);	// what the fault turned out to be
+    void Evicted(bool dirty);		// a victim had to be evicted
+    void End(FaultRecord **record, const char *programName,
+	     unsigned int vpn);		// the fault on "vpn" is resolved;
+					// "record" is the address space's
+					// record, created on its first fault
+
+    void WriteReport();			// write the JSON report
+
+  private:
+    char *fileName;			// where the report goes
+    FaultKind kind;			// kind of the fault in progress
+    int faultEvictions;			// evictions by the fault in progress
+    long long startHostTime;		// host time the fault started
+
+    int counts[NumFaultKinds];		// faults of each kind
+    long long hostTime[NumFaultKinds];	// host microseconds of each kind
+    int cleanEvictions;			// clean victims dropped
+    int dirtyEvictions;			// dirty victims written out
+
+    FaultRecord *records;		// one per address space, in
+    FaultRecord *lastRecord;		// order of creation
+    int numRecords;
+};
+
+#endif // FAULTSTATS_H
@@ -0,0 +1,194 @@
+// sharedmem.cc
+//	Routines to keep track of shared memory segments.  Faulting the
+//	pages in and out is done by AddrSpace, like for any other page;
+//	the segment only knows where its pages are, and who maps them.
+
+#include "copyright.h"
+#include "sharedmem.h"
+#include "system.h"
+#include "addrspace.h"
+
+//----------------------------------------------------------------------
+// SharedSegment::SharedSegment
+// 	Initialize a segment of "size" pages.  No page has a frame until
+//	it is touched.
+//----------------------------------------------------------------------
+
+SharedSegment::SharedSegment(int segmentId, int size)
+{
+    id = segmentId;
+    numPages = size;
+    pages = new TranslationEntry[numPages];
+    for (int i = 0; i < numPages; i++) {
+	pages[i].virtualPage = i;
+	pages[i].physicalPage = -1;
+	pages[i].valid = false;
+	pages[i].use = false;
+	pages[i].dirty = false;
+	pages[i].readOnly = false;
+    }
+    attachments = NULL;
+}
+
+//----------------------------------------------------------------------
+// SharedSegment::~SharedSegment
+// 	Give back the frames and swap slots of the segment's pages.
+//----------------------------------------------------------------------
+
+SharedSegment::~SharedSegment()
+{
+    char scratch[PageSize];
+
+    ASSERT(attachments == NULL);
+    for (int i = 0; i < numPages; i++) {
+	if (pages[i].valid) {
+	    int frame = pages[i].physicalPage;
+	    IPT[frame] = NULL;
+	    IPTSegment[frame] = NULL;
+	    MemBitMap->Clear(frame);
+	} else if (pages[i].dirty) {		// in the swap
+	    if (swapCache != NULL)
+		swapCache->Get(pages[i].physicalPage, scratch);
+	    SWAPBitMap->Clear(pages[i].physicalPage);
+	}
+    }
+    delete [] pages;
+}
+
+//----------------------------------------------------------------------
+// SharedSegment::Attach, SharedSegment::Detach
+// 	Keep the list of address spaces that map the segment, and where.
+//----------------------------------------------------------------------
+
+void
+SharedSegment::Attach(AddrSpace *space, unsigned int firstPage)
+{
+    SharedAttachment *attachment = new SharedAttachment;
+    attachment->space = space;
+    attachment->firstPage = firstPage;
+    attachment->next = attachments;
+    attachments = attachment;
+}
+
+bool
+SharedSegment::Detach(AddrSpace *space, unsigned int firstPage)
+{
+    SharedAttachment **link = &attachments;
+    while (*link != NULL) {
+	SharedAttachment *attachment = *link;
+	if (attachment->space == space && attachment->firstPage == firstPage) {
+	    *link = attachment->next;
+	    delete attachment;
+	    break;
+	}
+	link = &attachment->next;
+    }
+    return attachments == NULL;
+}
+
+//----------------------------------------------------------------------
+// SharedSegment::PageOut
+// 	The frame of "page" was taken away: its master entry already
+//	says where the page went, so throw away every copy of the old one.
+//----------------------------------------------------------------------
+
+void
+SharedSegment::PageOut(int page)
+{
+    for (SharedAttachment *a = attachments; a != NULL; a = a->next)
+	a->space->dropSharedPage(a->firstPage + page);
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::SharedMemory
+// 	Initialize an empty table of segments.
+//----------------------------------------------------------------------
+
+SharedMemory::SharedMemory()
+{
+    for (int i = 0; i < MaxSharedSegments; i++)
+	segments[i] = NULL;
+    numCreated = numAttaches = 0;
+}
+
+SharedMemory::~SharedMemory()
+{
+    for (int i = 0; i < MaxSharedSegments; i++)
+	delete segments[i];
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Create
+// 	Make a segment big enough for "size" bytes.  Return its id, or
+//	-1 if the size is wrong or there are too many segments.
+//----------------------------------------------------------------------
+
+int
+SharedMemory::Create(int size)
+{
+    int numPages = divRoundUp(size, PageSize);
+
+    if (size <= 0 || numPages > MaxSharedPages)
+	return -1;
+    for (int id = 0; id < MaxSharedSegments; id++) {
+	if (segments[id] == NULL) {
+	    segments[id] = new SharedSegment(id, numPages);
+	    numCreated++;
+	    DEBUG('v', "Shared segment %d, %d pages\n", id, numPages);
+	    return id;
+	}
+    }
+    return -1;
+}
+
+SharedSegment *
+SharedMemory::Get(int id)
+{
+    if (id < 0 || id >= MaxSharedSegments)
+	return NULL;
+    return segments[id];
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Attached, SharedMemory::Detached
+// 	Record that "space" maps "segment" from "firstPage" on, or no
+//	longer does.  A segment lives until its last attachment goes.
+//----------------------------------------------------------------------
+
+void
+SharedMemory::Attached(SharedSegment *segment, AddrSpace *space,
+		       unsigned int firstPage)
+{
+    segment->Attach(space, firstPage);
+    numAttaches++;
+}
+
+void
+SharedMemory::Detached(SharedSegment *segment, AddrSpace *space,
+		       unsigned int firstPage)
+{
+    if (segment->Detach(space, firstPage)) {
+	DEBUG('v', "Shared segment %d freed\n", segment->id);
+	segments[segment->id] = NULL;
+	delete segment;
+    }
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Print
+// 	Print the shared memory statistics, at system shutdown, if
+//	any segment was made.
+//----------------------------------------------------------------------
+
+void
+SharedMemory::Print()
+{
+    int live = 0;
+    if (numCreated == 0)
+	return;
+    for (int i = 0; i < MaxSharedSegments; i++)
+	if (segments[i] != NULL)
+	    live++;
+    printf("Shared memory: %d segments created, %d attaches, %d live\n",
+	numCreated, numAttaches, live);
+}
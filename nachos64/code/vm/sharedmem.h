@@ -0,0 +1,85 @@
+// sharedmem.h
+//	Data structures for shared memory segments, made with ShmCreate
+//	and mapped into address spaces with ShmAttach.
+//
+//	A segment owns one master translation entry per page, that says
+//	where the page is: in a physical frame, in the swap file (invalid
+//	and dirty, with the swap slot in "physicalPage", as for any other
+//	page), or nowhere yet (it is zero filled on the first fault).
+//	The frame table points to the master entry of a resident shared
+//	page, with the segment in IPTSegment, so the page can be chosen
+//	as a victim like any other.
+//
+//	Each address space that attaches the segment maps it as a region
+//	(see MappedRegion in addrspace.h); its page table entries are
+//	copies of the master ones, filled in on a page fault.  When a
+//	shared page is evicted, every copy is invalidated, so each space
+//	faults and finds the page again wherever it is brought back.
+
+#ifndef SHAREDMEM_H
+#define SHAREDMEM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "translate.h"
+
+class AddrSpace;
+
+#define MaxSharedSegments	16	// segments in the system
+#define MaxSharedPages		32	// pages in one segment
+
+// The following class defines one place where a segment is attached.
+
+class SharedAttachment {
+  public:
+    AddrSpace *space;		// the address space
+    unsigned int firstPage;	// virtual page of the segment's page 0
+    SharedAttachment *next;	// other attachments of the segment
+};
+
+// The following class defines a shared memory segment.
+
+class SharedSegment {
+  public:
+    SharedSegment(int segmentId, int size);	// Initialize an empty
+					// segment of "size" pages
+    ~SharedSegment();			// Free its frames and swap slots
+
+    void Attach(AddrSpace *space, unsigned int firstPage);
+    bool Detach(AddrSpace *space, unsigned int firstPage);
+					// Forget an attachment, return true
+					// if it was the last one
+    void PageOut(int page);		// "page" was evicted, invalidate
+					// every copy of its entry
+
+    int id;				// ShmCreate's return value
+    int numPages;			// pages in the segment
+    TranslationEntry *pages;		// master entries, one per page
+    SharedAttachment *attachments;	// where the segment is attached
+};
+
+// The following class defines the table of shared memory segments.
+
+class SharedMemory {
+  public:
+    SharedMemory();			// Initialize an empty table
+    ~SharedMemory();			// Free every segment left
+
+    int Create(int size);		// Make a segment of "size" bytes,
+					// return its id or -1
+    SharedSegment *Get(int id);		// The segment "id", or NULL
+    void Attached(SharedSegment *segment, AddrSpace *space,
+		  unsigned int firstPage);
+    void Detached(SharedSegment *segment, AddrSpace *space,
+		  unsigned int firstPage);	// Free the segment when
+					// the last attachment goes
+    void Print();			// Print the statistics
+
+  private:
+    SharedSegment *segments[MaxSharedSegments];	// NULL if id unused
+
+    int numCreated;			// segments made
+    int numAttaches;			// ShmAttach calls that worked
+};
+
+#endif // SHAREDMEM_H
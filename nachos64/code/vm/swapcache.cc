@@ -0,0 +1,214 @@
+// swapcache.cc
+//	Routines to keep compressed copies of swapped out pages in host
+//	memory, in front of the swap file.
+//
+//	A compressed page is a sequence of runs.  Each run starts with
+//	a header byte:
+//
+//		1nnnnnnn -- the next word is repeated n+1 times
+//		0nnnnnnn -- the next n+1 words are copied verbatim
+//
+//	Words are copied as raw bytes, so the encoding doesn't depend on
+//	the byte order of either the host or the simulated machine.
+
+#include "copyright.h"
+#include "swapcache.h"
+
+const int WordsPerPage = PageSize / 4;
+const int MaxRunLength = 128;
+
+//----------------------------------------------------------------------
+// SwapCache::SwapCache
+// 	Initialize an empty swap cache.
+//
+//	"poolBytes" is the maximum amount of host memory, in bytes, that
+//	compressed pages may take up.
+//----------------------------------------------------------------------
+
+SwapCache::SwapCache(int poolBytes)
+{
+    entries = new SwapCacheEntry[SWAPSize];
+    for (int i = 0; i < SWAPSize; i++) {
+	entries[i].data = NULL;
+	entries[i].size = 0;
+	entries[i].compressed = false;
+    }
+    // worst case: one header byte per word, plus the words themselves
+    scratch = new char[PageSize + WordsPerPage];
+    poolSize = poolBytes;
+    poolUsed = 0;
+
+    numStores = numSpills = numHits = numMisses = 0;
+    bytesIn = bytesOut = 0;
+}
+
+//----------------------------------------------------------------------
+// SwapCache::~SwapCache
+// 	De-allocate every page still held in the cache.
+//----------------------------------------------------------------------
+
+SwapCache::~SwapCache()
+{
+    for (int i = 0; i < SWAPSize; i++)
+	delete [] entries[i].data;
+    delete [] entries;
+    delete [] scratch;
+}
+
+//----------------------------------------------------------------------
+// SwapCache::Compress
+// 	Run length encode one page.  Return the number of bytes written
+//	into "into", which must have room for PageSize + WordsPerPage bytes.
+//----------------------------------------------------------------------
+
+int
+SwapCache::Compress(const char *from, char *into)
+{
+    int out = 0;
+    int word = 0;
+
+    while (word < WordsPerPage) {
+	int run = 1;
+	while (word + run < WordsPerPage && run < MaxRunLength
+	       && memcmp(from + 4 * word, from + 4 * (word + run), 4) == 0)
+	    run++;
+
+	if (run > 1) {			// repeated word
+	    into[out++] = (char) (0x80 | (run - 1));
+	    memcpy(into + out, from + 4 * word, 4);
+	    out += 4;
+	} else {			// literal words, up to the next repeat
+	    int count = 1;
+	    while (word + count < WordsPerPage && count < MaxRunLength
+		   && (word + count + 1 >= WordsPerPage
+		       || memcmp(from + 4 * (word + count),
+				 from + 4 * (word + count + 1), 4) != 0))
+		count++;
+	    run = count;
+	    into[out++] = (char) (run - 1);
+	    memcpy(into + out, from + 4 * word, 4 * run);
+	    out += 4 * run;
+	}
+	word += run;
+    }
+    return out;
+}
+
+//----------------------------------------------------------------------
+// SwapCache::Decompress
+// 	Expand a page compressed by SwapCache::Compress into "into".
+//----------------------------------------------------------------------
+
+void
+SwapCache::Decompress(const char *from, int size, char *into)
+{
+    int in = 0;
+    int word = 0;
+
+    while (in < size) {
+	unsigned char header = (unsigned char) from[in++];
+	int run = (header & 0x7f) + 1;
+
+	ASSERT(word + run <= WordsPerPage);
+	if (header & 0x80) {
+	    for (int i = 0; i < run; i++)
+		memcpy(into + 4 * (word + i), from + in, 4);
+	    in += 4;
+	} else {
+	    memcpy(into + 4 * word, from + in, 4 * run);
+	    in += 4 * run;
+	}
+	word += run;
+    }
+    ASSERT(word == WordsPerPage);
+}
+
+//----------------------------------------------------------------------
+// SwapCache::Put
+// 	Keep a compressed copy of the page at "from", under swap slot
+//	"swapPage".  If the page doesn't compress, it is kept verbatim.
+//
+//	Returns false if the pool has no room for the page; the caller
+//	is then responsible for writing it to the swap file.
+//----------------------------------------------------------------------
+
+bool
+SwapCache::Put(int swapPage, const char *from)
+{
+    ASSERT(swapPage >= 0 && swapPage < SWAPSize);
+    ASSERT(entries[swapPage].data == NULL);
+
+    int size = Compress(from, scratch);
+    bool compressed = size < PageSize;
+    if (!compressed)
+	size = PageSize;
+
+    if (poolUsed + size > poolSize) {
+	DEBUG('h', "Swap cache full, spilling swap page %d\n", swapPage);
+	numSpills++;
+	return false;
+    }
+
+    entries[swapPage].data = new char[size];
+    memcpy(entries[swapPage].data, compressed ? scratch : from, size);
+    entries[swapPage].size = size;
+    entries[swapPage].compressed = compressed;
+    poolUsed += size;
+
+    numStores++;
+    bytesIn += PageSize;
+    bytesOut += size;
+    DEBUG('h', "Swap cache stores swap page %d in %d bytes\n", swapPage, size);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// SwapCache::Get
+// 	Copy the page cached under swap slot "swapPage" into "into", and
+//	release its space in the pool.
+//
+//	Returns false if the page isn't cached, so it must be read from
+//	the swap file.
+//----------------------------------------------------------------------
+
+bool
+SwapCache::Get(int swapPage, char *into)
+{
+    ASSERT(swapPage >= 0 && swapPage < SWAPSize);
+    SwapCacheEntry *entry = &entries[swapPage];
+
+    if (entry->data == NULL) {
+	numMisses++;
+	return false;
+    }
+
+    if (entry->compressed)
+	Decompress(entry->data, entry->size, into);
+    else
+	memcpy(into, entry->data, PageSize);
+
+    poolUsed -= entry->size;
+    delete [] entry->data;
+    entry->data = NULL;
+    entry->size = 0;
+
+    numHits++;
+    DEBUG('h', "Swap cache hit on swap page %d\n", swapPage);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// SwapCache::Print
+// 	Print the swap cache statistics, at system shutdown.
+//----------------------------------------------------------------------
+
+void
+SwapCache::Print()
+{
+    double ratio = (bytesOut > 0) ? (double) bytesIn / bytesOut : 0.0;
+
+    printf("Swap cache: stores %d, spills %d, hits %d, misses %d\n",
+	numStores, numSpills, numHits, numMisses);
+    printf("Swap cache: pool %d/%d bytes, compression ratio %.2f\n",
+	poolUsed, poolSize, ratio);
+}
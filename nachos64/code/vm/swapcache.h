@@ -0,0 +1,75 @@
+// swapcache.h
+//	Data structures for a compressed, in-memory cache of swapped out
+//	pages, that sits in front of the swap file.
+//
+//	When a dirty victim is evicted, AddrSpace first offers the page
+//	to the swap cache.  The page is compressed and kept in a bounded
+//	pool of host memory; only when the pool is full is the page
+//	written to SWAPFILENAME.  When the page is needed again, it is
+//	decompressed straight from the pool, without touching the file.
+//
+//	Pages are identified by their swap slot (the number handed out
+//	by SWAPBitMap), so a given slot is either in the cache or in the
+//	swap file, never both.
+//
+//	The compression is a simple word oriented run length encoding.
+//	User data pages (int matrices, arrays being sorted, the stack)
+//	are mostly zeros or repeated words, so this is enough to get a
+//	good ratio without pulling in a compression library.
+
+#ifndef SWAPCACHE_H
+#define SWAPCACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "machine.h"
+
+// Default size of the pool of compressed pages, in bytes
+const int SwapCacheDefaultSize = 16 * PageSize;
+
+// The following class defines one compressed page kept in the cache.
+
+class SwapCacheEntry {
+  public:
+    char *data;			// compressed contents, NULL if slot unused
+    int size;			// number of bytes in "data"
+    bool compressed;		// false if the page was stored verbatim
+};
+
+// The following class defines the swap cache.  "Put" and "Get" are
+// called from the page fault path, with the swap slot of the page.
+
+class SwapCache {
+  public:
+    SwapCache(int poolBytes);		// Initialize an empty cache with
+					// room for "poolBytes" of pages
+    ~SwapCache();			// De-allocate the cached pages
+
+    bool Put(int swapPage, const char *from);
+					// Compress and keep the page at
+					// "from"; return false if the pool
+					// is full, so the caller must write
+					// the page to the swap file
+    bool Get(int swapPage, char *into);	// Decompress the page into "into"
+					// and drop it from the cache; return
+					// false if it isn't cached
+    void Print();			// Print the cache statistics
+
+  private:
+    SwapCacheEntry *entries;		// one entry per swap slot
+    char *scratch;			// buffer to compress one page into
+    int poolSize;			// maximum bytes of cached pages
+    int poolUsed;			// bytes currently cached
+
+    int numStores;			// pages kept in the pool
+    int numSpills;			// pages that had to go to the file
+    int numHits;			// swap-ins satisfied by the pool
+    int numMisses;			// swap-ins that had to read the file
+    long bytesIn;			// uncompressed bytes stored
+    long bytesOut;			// compressed bytes stored
+
+    int Compress(const char *from, char *into);
+    void Decompress(const char *from, int size, char *into);
+};
+
+#endif // SWAPCACHE_H